@@ -7,6 +7,14 @@
 #include <glm/gtc/matrix_transform.hpp> // For transformations like perspective, lookAt, etc.
 #include <GLFW/glfw3.h>
 
+// Orbit placement: yaw and pitch in degrees around Target, Distance away from it
+struct OrbitPose {
+    float Yaw = -90.0f;
+    float Pitch = 60.0f;
+    float Distance = 0.65f;
+    glm::vec3 Target = glm::vec3(0.0f, 0.125f, 0.0f);
+};
+
 class Camera
 {
 public:
@@ -19,6 +27,7 @@ public:
     void processMouseScroll(float yOffset);
     void processMousePan(float xOffset, float yOffset);
     void resetView();
+    void setOrbit(const OrbitPose& pose);
 
     void setWindow(GLFWwindow* window);
     void update();
@@ -0,0 +1,69 @@
+#ifndef DEBUG_DRAW_HPP
+#define DEBUG_DRAW_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "lineTechnique.hpp"
+
+// Immediate-mode debug primitives in world space. add*() only queues vertices on the CPU;
+// flush() copies the frame's vertices into one region of a persistently mapped ring buffer
+// and issues a single draw per primitive type. All GL objects are created in init(); the CPU
+// queues grow to the largest frame seen, so a frame in steady state allocates neither.
+class DebugDraw
+{
+public:
+    // Vertices per frame, shared by all primitive types. Extra primitives are dropped.
+    static const uint32_t MAX_VERTICES = 1 << 18;
+
+    DebugDraw() {}
+    ~DebugDraw();
+
+    bool init();
+
+    // Without depthTest the line is drawn over the scene
+    void addLine(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color, bool depthTest = true);
+    void addPoint(const glm::vec3& position, const glm::vec3& color);
+    // Drawn as wireframe
+    void addTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& color);
+
+    // Draws and clears everything queued since the previous flush. Expects FrameData to be current.
+    void flush();
+
+    float getPointSize() const { return m_pointSize; }
+    void setPointSize(float size) { m_pointSize = size; }
+
+private:
+    // GPU regions in flight. flush() waits on the fence of the region it is about to overwrite.
+    static const uint32_t NUM_REGIONS = 3;
+
+    struct Vertex {
+        glm::vec3 Position;
+        uint32_t Color; // RGBA8
+    };
+
+    static uint32_t packColor(const glm::vec3& color);
+    bool reserveVertices(uint32_t count);
+    void clearQueues();
+
+    LineTechnique m_technique;
+    GLuint m_VAO = 0;
+    GLuint m_VBO = 0;
+    Vertex* m_pMapped = nullptr;
+    GLsync m_fences[NUM_REGIONS] = {};
+    uint32_t m_region = 0;
+    float m_pointSize = 3.0f;
+    bool m_overflowReported = false;
+
+    // Together never more than MAX_VERTICES, the size of one ring region
+    uint32_t m_numQueued = 0;
+    std::vector<Vertex> m_lines;
+    std::vector<Vertex> m_overlayLines; // drawn without depth testing
+    std::vector<Vertex> m_points;
+    std::vector<Vertex> m_triangles;
+};
+
+#endif // DEBUG_DRAW_HPP
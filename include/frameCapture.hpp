@@ -0,0 +1,88 @@
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "threadPool.hpp"
+
+// Records rendered frames without stalling on readback. Each frame is read into one of
+// NUM_SLOTS pixel-pack buffers by an asynchronous glReadPixels and fenced; the buffer is only
+// mapped once its fence has signaled, typically while the frame two later is rendering. The
+// pixels then go to worker threads that encode PNGs, or to a single ordered writer that
+// appends them to a Y4M stream. A frame is dropped rather than waited for when its slot is
+// still in flight or the encoders have fallen too far behind.
+class FrameCapture
+{
+public:
+    enum FORMAT {
+        FORMAT_PNG, // one file per frame in a directory
+        FORMAT_Y4M  // single uncompressed 4:2:0 stream, playable and encodable with ffmpeg
+    };
+
+    FrameCapture() {}
+    ~FrameCapture();
+
+    // A path ending in .y4m records a stream, any other path is the PNG directory
+    bool start(const std::string& path, int width, int height, int fps);
+    // Collects the frames still in flight, waits for the encoders and prints the statistics
+    void stop();
+    bool isActive() const { return m_active; }
+
+    // Queues the readback of the current read framebuffer; call after rendering, before swapping
+    void captureFrame(int width, int height);
+
+    uint64_t getNumCaptured() const { return m_numCaptured; }
+    uint64_t getNumDropped() const { return m_numDropped; }
+    // Frames handed to the encoders per second of wall time since start()
+    double getCaptureFps() const;
+
+private:
+    static const uint32_t NUM_SLOTS = 3;
+    static const size_t MAX_PENDING_ENCODES = 8; // frames queued on the CPU before new ones are dropped
+
+    struct Slot {
+        GLuint PBO = 0;
+        GLsync Fence = nullptr;
+    };
+
+    void collect(Slot& slot);
+    void encodePng(std::vector<unsigned char>& pixels, uint64_t frameIndex);
+    void writeY4m(const std::vector<unsigned char>& pixels);
+
+    std::vector<unsigned char> acquireBuffer();
+    void releaseBuffer(std::vector<unsigned char>&& buffer);
+
+    FORMAT m_format = FORMAT_PNG;
+    std::string m_path;
+    int m_width = 0;
+    int m_height = 0;
+    size_t m_frameBytes = 0;
+    bool m_active = false;
+
+    Slot m_slots[NUM_SLOTS];
+    uint32_t m_nextSlot = 0;
+
+    std::unique_ptr<ThreadPool> m_pEncoders;
+    FILE* m_pY4mFile = nullptr;
+    std::vector<unsigned char> m_yuv; // only touched by the single Y4M writer thread
+
+    std::mutex m_bufferMutex;
+    std::vector<std::vector<unsigned char>> m_freeBuffers;
+
+    uint64_t m_numCaptured = 0;
+    uint64_t m_numDropped = 0;
+    std::atomic<uint64_t> m_numWriteErrors = 0;
+    bool m_sizeMismatchReported = false;
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+#endif // FRAME_CAPTURE_HPP
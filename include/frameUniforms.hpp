@@ -0,0 +1,57 @@
+#ifndef FRAME_UNIFORMS_HPP
+#define FRAME_UNIFORMS_HPP
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+// Uniform buffer binding point of the FrameData block, assigned to every program in Technique::Finalize()
+#define FRAME_DATA_BINDING 0
+
+// GLSL declaration of FrameData, spliced into shader sources right after the #version line
+#define FRAME_DATA_GLSL                                                 \
+    "layout(std140) uniform FrameData\n"                                \
+    "{\n"                                                               \
+    "    mat4 gView;\n"                                                 \
+    "    mat4 gProjection;\n"                                           \
+    "    mat4 gViewProjection;\n"                                       \
+    "    vec4 gViewPos;\n"                                              \
+    "    vec4 gLightPos;\n"                                             \
+    "    vec4 gLightColor;\n"                                           \
+    "    vec4 gAttenuation; // constant, linear, quadratic\n"           \
+    "};\n"
+
+// Camera and lighting state shared by all programs. Only vec4 and mat4 members are used
+// so the C++ layout matches std140 without padding.
+struct FrameData
+{
+    glm::mat4 View = glm::mat4(1.0f);
+    glm::mat4 Projection = glm::mat4(1.0f);
+    glm::mat4 ViewProjection = glm::mat4(1.0f);
+    glm::vec4 ViewPos = glm::vec4(0.0f);
+    glm::vec4 LightPos = glm::vec4(0.0f);
+    glm::vec4 LightColor = glm::vec4(0.0f);
+    glm::vec4 Attenuation = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+};
+
+static_assert(sizeof(FrameData) == 256, "FrameData must match the std140 layout of FRAME_DATA_GLSL");
+
+// Owns the uniform buffer behind FrameData. update() uploads the whole block once per frame,
+// before any draw, and binds it at FRAME_DATA_BINDING.
+class FrameUniforms
+{
+public:
+    FrameUniforms() {}
+    ~FrameUniforms();
+
+    bool init();
+    void update(const FrameData& data);
+
+    const FrameData& getData() const { return m_data; }
+
+private:
+    GLuint m_UBO = 0;
+    FrameData m_data;
+};
+
+#endif // FRAME_UNIFORMS_HPP
@@ -32,9 +32,19 @@
 #include "imgui_impl_opengl3.h"
 
 #include "camera.hpp"
+#include "debugDraw.hpp"
+#include "frameCapture.hpp"
+#include "frameUniforms.hpp"
 #include "grid.hpp"
+#include "headlessContext.hpp"
+#include "lightingTechnique.hpp"
 #include "mesh.hpp"
 #include "math3d.hpp"
+#include "offscreenTarget.hpp"
+#include "profiler.hpp"
+#include "programCache.hpp"
+#include "simulationClock.hpp"
+#include "trace.hpp"
 #include "utils.hpp"
 
 #define WINDOW_WIDTH  1920
@@ -47,9 +57,24 @@ public:
 
     void gui(GLFWwindow* window);
     int init();
-    bool loadModel(const std::string& filePath);
+    // Windowless init on an EGL context; frames go to an offscreen framebuffer of the given size
+    int initHeadless(int width, int height);
+    // Imports on the loader thread while the driver compiles the lighting programs; blocks until
+    // both are done unless options.Async is set
+    bool loadModel(const std::string& filePath, const Mesh::LoadOptions& options = Mesh::LoadOptions());
     void setCallbacks(GLFWwindow* window);
+    // Takes effect once loadModel() has built the techniques, and only with GL 4.3
+    void setIndirectDraw(bool enabled) { m_indirectDraw = enabled; }
+    // Start of the process, the reference for the launch to first frame time
+    void setLaunchTime(std::chrono::steady_clock::time_point launchTime) { m_launchTime = launchTime; }
+    // Redraw only when input, camera, animation or loading changed something; otherwise block on events
+    void setRenderOnDemand(bool enabled) { m_renderOnDemand = enabled; requestRedraw(); }
     void run(int runForSeconds);
+    void benchmarkNormalMatrix(int numFrames);
+    // Records every drawn frame to path (a .y4m stream or a PNG directory) until C is pressed or run() ends
+    bool startCapture(const std::string& path);
+    // Renders numFrames frames, cycling through poses, and writes them as outputDir/frame_NNNN.png
+    bool renderHeadless(const std::vector<OrbitPose>& poses, int numFrames, const std::string& outputDir);
 
 private:
     void cbError();
@@ -59,33 +84,81 @@ private:
     void cbRenderCB();
     void cbScroll(GLFWwindow* window, double xoffset, double yoffset);
     void cbSpecialKeyboard(int key, int mouse_x, int mouse_y);
-    void cbTimer(int interval);
 
-    GLuint compileShader(GLenum type, const char* source);
-    GLuint createShaderProgram();
-    GLuint createWireframeShaderProgram();
-    GLuint createSimpleShaderProgram();
-    void drawLightLine(const glm::vec3& lightPos, const glm::vec3& lightTarget, const glm::mat4& mvp, GLuint shaderProgram);
+    void drawLightLine(const glm::vec3& lightPos, const glm::vec3& lightTarget);
     void handleSnapToBorders(GLFWwindow* pWindow);
+    bool initLightingTechniques(bool quantized);
+    bool completeLightingTechniques();
+    int initRenderer();
+    void renderFrame(int width, int height);
+    void renderMesh();
+    void reportSubmitTimings();
+    void reportLoadTimings();
+    void stepSimulation(float dt);
+    void requestRedraw() { m_redrawFrames = REDRAW_FRAMES_AFTER_INPUT; }
+    bool needsRedraw(const glm::mat4& newView) const;
+    bool shutdownDue();
+    void waitForEvents();
+    void updateSimulation();
     void updateProjectionMatrix(int width, int height);
-    void updateLightning(const GLuint shaderProgram);
+    void updateFrameData();
+    void updateLightning(FrameData& frameData);
 
 private:
-    static const char* vertexShaderSource;
-    static const char* fragmentShaderSource;
-    static const char* wireframeShaderSource;
-    static const char* lineShaderSource;
-    static const char* lineFragmentShader;
-
-    bool tick = false;
-    bool toggle = false;
+    // CPU time of the mesh submission call, accumulated per mode for the direct vs indirect comparison
+    struct SubmitTiming {
+        double TotalMs = 0.0;
+        uint64_t Frames = 0;
+    };
+
+    // Animated state at a simulation step; rendering blends the previous and current one
+    struct SimulationState {
+        float LightAngle = 0.0f; // radians
+        float MeshAngle = 0.0f;  // degrees
+    };
+
+    // Headless frames advance the simulation by a fixed frame time so the images are reproducible
+    static constexpr double HEADLESS_FRAME_SECONDS = 1.0 / 60.0;
+
+    // Declared first so it is destroyed after every member that owns GL objects
+    std::unique_ptr<HeadlessContext> m_pHeadlessContext;
+    OffscreenTarget m_offscreenTarget;
+    FrameCapture m_frameCapture;
+    std::string m_capturePath = "capture";
+
+    // ImGui needs a couple of frames after an event to settle hover and popup state
+    static const int REDRAW_FRAMES_AFTER_INPUT = 3;
+    // Upper bound on a blocking wait; the loop still checks the window state this often
+    static constexpr double IDLE_WAIT_SECONDS = 1.0;
+
+    bool m_renderOnDemand = false;
+    int m_redrawFrames = REDRAW_FRAMES_AFTER_INPUT;
+    uint64_t m_framesRendered = 0;
+    uint64_t m_framesSkipped = 0; // wakeups that found nothing to redraw
+    double m_idleSeconds = 0.0;
+
+    SimulationClock m_clock;
+    SimulationState m_previousState;
+    SimulationState m_currentState;
+    bool m_lampHighlight = false;
     bool runIndifinitely = false;
+    bool m_timedRun = false;
+    std::chrono::steady_clock::time_point m_shutdownTime;
+    long m_shutdownCountdown = 0; // last whole second printed
     glm::mat4 mvp, model, view, projection;
-    GLuint m_shaderProgram;
-    GLuint m_wireframeProgram;
-    GLuint m_lightProgram;
-    GLFWwindow *pWindow;
+    std::unique_ptr<LightingTechnique> m_pLightingTechnique;
+    std::unique_ptr<LightingTechnique> m_pIndirectLightingTechnique; // null without GL 4.3
+    bool m_indirectDraw = false;
+    SubmitTiming m_submitTimings[2]; // direct, indirect
+    DebugDraw m_debugDraw;
+    Profiler m_profiler;
+    FrameUniforms m_frameUniforms;
+    GLFWwindow *pWindow = nullptr; // null when headless
     Mesh *pMesh = NULL;
+    std::chrono::steady_clock::time_point m_launchTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point m_loadStart;
+    bool m_firstFrameReported = false;
+    bool m_loadReported = false;
     Camera *pCamera = NULL;
 };
 
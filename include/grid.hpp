@@ -7,6 +7,7 @@
 #include <GL/glew.h>
 
 #include "math3d.hpp"
+#include "technique.hpp"
 
 namespace Grid
 {
@@ -19,23 +20,39 @@ namespace Grid
         float MinPixelsBetweenCells = 2.0f;
     };
 
-    struct GridMatrices {
-        glm::mat4 View;
-        glm::mat4 Projection;
+    class GridTechnique : public Technique
+    {
+    public:
+        GridTechnique() {}
+        ~GridTechnique();
 
-        GridMatrices(const glm::mat4& view, const glm::mat4& projection)
-            : View(view), Projection(projection) {}
+        virtual bool Init();
+        // Binds the program and the empty VAO the attribute-less quad is drawn with
+        bool Enable();
+
+        void SetConfig(const InfiniteGridConfig& config);
+
+    protected:
+        virtual bool OnLinked();
+
+    private:
+        GLuint m_VAO = 0;
+        GLint m_gridSizeLoc = -1;
+        GLint m_gridCellSizeLoc = -1;
+        GLint m_gridColorThinLoc = -1;
+        GLint m_gridColorThickLoc = -1;
+        GLint m_gridMinPixelsBetweenCellsLoc = -1;
     };
 
     extern const char* VertexShader;
     extern const char* FragmentShader;
 
     extern InfiniteGridConfig config;
-    extern GLuint m_gridProgram;
+    extern GridTechnique* m_pGridTechnique;
 
-    GLuint compileShader(GLenum type, const char* source);
-    GLuint createShaderProgram();
-    void renderGrid(const GridMatrices mats, const Vector3f& cameraPosition);
+    bool init();
+    void renderGrid();
+    void shutdown();
 };
 
 #endif // GRID_HPP
\ No newline at end of file
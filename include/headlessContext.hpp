@@ -0,0 +1,30 @@
+#ifndef HEADLESS_CONTEXT_HPP
+#define HEADLESS_CONTEXT_HPP
+
+#include <EGL/egl.h>
+
+// Desktop OpenGL context without a window or display server, for rendering on CI and batch
+// machines. EGL displays are tried in order: the first GPU device (EGL_EXT_platform_device),
+// Mesa's surfaceless platform, then the default display. Contexts are made current without a
+// surface when EGL_KHR_surfaceless_context is available, otherwise on a 1x1 pbuffer; either
+// way all rendering has to go to a framebuffer object.
+class HeadlessContext
+{
+public:
+    HeadlessContext() {}
+    ~HeadlessContext();
+
+    bool init(int majorVersion, int minorVersion);
+
+    const char* getPlatformName() const { return m_pPlatformName; }
+
+private:
+    bool initDisplay();
+
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    EGLSurface m_surface = EGL_NO_SURFACE;
+    const char* m_pPlatformName = "none";
+};
+
+#endif // HEADLESS_CONTEXT_HPP
@@ -0,0 +1,56 @@
+#ifndef IMPORT_PROFILE_HPP
+#define IMPORT_PROFILE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+// Named sets of Assimp post-process steps, from cheapest to most complete for rendering.
+// Nothing in gizmo.cpp reads tangents or generated UVs, so no profile asks for them.
+enum IMPORT_PROFILE {
+    IMPORT_PROFILE_FAST_PREVIEW = 0,   // triangulated, welded and lit; nothing else
+    IMPORT_PROFILE_RENDER_QUALITY = 1, // previous ASSIMP_LOAD_FLAGS minus tangents and UV generation
+    IMPORT_PROFILE_COLLISION_ONLY = 2  // clean welded triangles, no normals
+};
+
+class ImportProfile
+{
+public:
+    struct StepTiming {
+        std::string Name;
+        double Ms = 0.0;
+    };
+
+    static unsigned int getFlags(IMPORT_PROFILE profile);
+    static const char* getName(IMPORT_PROFILE profile);
+    static bool parse(const std::string& name, IMPORT_PROFILE& profile);
+
+    // Reads without post-processing, then applies the requested steps one at a time in Assimp's
+    // own pipeline order so each can be timed. Produces the same scene as ReadFile(filename, flags).
+    static const aiScene* readFileByStep(Assimp::Importer& importer, const std::string& filename,
+                                         unsigned int flags, std::vector<StepTiming>& timings);
+    static void printTimings(const std::vector<StepTiming>& timings);
+};
+
+// Reports read and post-process progress of an import; safe to poll from another thread.
+// Install with Importer::SetProgressHandler, which takes ownership.
+class ImportProgressHandler : public Assimp::ProgressHandler
+{
+public:
+    void reset() { m_progress = 0.0f; }
+    float getProgress() const { return m_progress; }
+
+    // Assimp maps file reading to [0, 0.5] and post-processing to [0.5, 1]
+    bool Update(float percentage = -1.f) override;
+
+private:
+    std::atomic<float> m_progress = 0.0f;
+};
+
+#endif // IMPORT_PROFILE_HPP
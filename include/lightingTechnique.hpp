@@ -0,0 +1,51 @@
+#ifndef LIGHTING_TECHNIQUE_HPP
+#define LIGHTING_TECHNIQUE_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "technique.hpp"
+
+// Interface between Mesh::renderIndirect() and the INDIRECT_DRAW variant of the shaders
+#define DRAW_ID_LOCATION  4
+#define DRAW_DATA_BINDING 1
+
+// Point-lit solid shading used for meshes. Camera and light come from the FrameData uniform
+// block; the per-draw uniform locations are resolved once the program has linked.
+class LightingTechnique : public Technique
+{
+public:
+    // quantized dequantizes Mesh::VERTEX_FORMAT_QUANTIZED vertices in the vertex shader.
+    // indirect reads the model matrix, color and bounds per draw from the DRAW_DATA_BINDING
+    // storage buffer, so the per-draw setters below are unused (requires GL 4.3).
+    // normalMatrixInShader ignores SetNormalMatrix() and inverts the model matrix per vertex,
+    // only kept to benchmark against.
+    explicit LightingTechnique(bool quantized = false, bool indirect = false, bool normalMatrixInShader = false)
+        : m_quantized(quantized), m_indirect(indirect), m_normalMatrixInShader(normalMatrixInShader) {}
+
+    virtual bool Init();
+    bool IsQuantized() const { return m_quantized; }
+    bool IsIndirect() const { return m_indirect; }
+    bool IsNormalMatrixInShader() const { return m_normalMatrixInShader; }
+
+    void SetModel(const glm::mat4& model);
+    void SetNormalMatrix(const glm::mat3& normalMatrix);
+    void SetObjectColor(const glm::vec3& color);
+    void SetQuantization(const glm::vec3& min, const glm::vec3& extent);
+
+protected:
+    virtual bool OnLinked();
+
+private:
+    bool m_quantized = false;
+    bool m_indirect = false;
+    bool m_normalMatrixInShader = false;
+
+    GLint m_modelLoc = -1;
+    GLint m_normalMatrixLoc = -1;
+    GLint m_objectColorLoc = -1;
+    GLint m_quantMinLoc = -1;
+    GLint m_quantExtentLoc = -1;
+};
+
+#endif // LIGHTING_TECHNIQUE_HPP
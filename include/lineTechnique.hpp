@@ -0,0 +1,16 @@
+#ifndef LINE_TECHNIQUE_HPP
+#define LINE_TECHNIQUE_HPP
+
+#include "technique.hpp"
+
+// World-space positions with a per-vertex color, transformed by the FrameData view-projection.
+// Used by DebugDraw for lines, points and wireframe triangles.
+class LineTechnique : public Technique
+{
+public:
+    LineTechnique() {}
+
+    virtual bool Init();
+};
+
+#endif // LINE_TECHNIQUE_HPP
@@ -1,6 +1,8 @@
 #ifndef MATERIAL_H
 #define MATERIAL_H
 
+#include <memory>
+
 #include "texture.hpp"
 
 struct PBRMaterial
@@ -8,10 +10,10 @@ struct PBRMaterial
     float Roughness = 0.0f;
     bool IsMetal = false;
     Vector3f Color = Vector3f(0.0f, 0.0f, 0.0f);
-    Texture* pAlbedo = NULL;
-    Texture* pRoughness = NULL;
-    Texture* pMetallic = NULL;
-    Texture* pNormalMap = NULL;
+    std::shared_ptr<Texture> pAlbedo;
+    std::shared_ptr<Texture> pRoughness;
+    std::shared_ptr<Texture> pMetallic;
+    std::shared_ptr<Texture> pNormalMap;
 };
 
 class Material {
@@ -26,23 +28,13 @@ class Material {
 
     PBRMaterial PBRmaterial;
 
-    Texture* pDiffuse = NULL; // base color of the material
-    Texture* pSpecularExponent = NULL;
+    // Textures are shared through TextureCache, so several materials may hold the same one
+    std::shared_ptr<Texture> pDiffuse; // base color of the material
+    std::shared_ptr<Texture> pSpecularExponent;
 
     float m_transparencyFactor = 1.0f;
     float m_alphaTest = 0.0f;
 
-    ~Material()
-    {
-        if (pDiffuse) {
-            delete pDiffuse;
-        }
-
-        if (pSpecularExponent) {
-            delete pSpecularExponent;
-        }
-    }
-
     glm::vec3 getAmbientColor() const
     {
         return glm::vec3(AmbientColor.x, AmbientColor.y, AmbientColor.z);
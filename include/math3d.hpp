@@ -901,16 +901,40 @@ public:
         bool Inside =
             (m_leftClipPlane.Dot(p4D)   >= 0) &&
             (m_rightClipPlane.Dot(p4D)  <= 0) &&
-         //   (m_topClipPlane.Dot(p4D)    <= 0) &&
-         //   (m_bottomClipPlane.Dot(p4D) >= 0) &&
+            (m_topClipPlane.Dot(p4D)    <= 0) &&
+            (m_bottomClipPlane.Dot(p4D) >= 0) &&
             (m_nearClipPlane.Dot(p4D)   >= 0) &&
             (m_farClipPlane.Dot(p4D)    <= 0);
 
         return Inside;
     }
 
+    // Conservative box test against all six planes: the box is rejected only when it lies
+    // entirely outside one of them, so some boxes near the corners are reported as inside.
+    bool IsAABBInsideViewFrustum(const Vector3f& Min, const Vector3f& Max) const
+    {
+        return IsAABBInsidePlane(m_leftClipPlane, Min, Max, 1.0f) &&
+               IsAABBInsidePlane(m_rightClipPlane, Min, Max, -1.0f) &&
+               IsAABBInsidePlane(m_topClipPlane, Min, Max, -1.0f) &&
+               IsAABBInsidePlane(m_bottomClipPlane, Min, Max, 1.0f) &&
+               IsAABBInsidePlane(m_nearClipPlane, Min, Max, 1.0f) &&
+               IsAABBInsidePlane(m_farClipPlane, Min, Max, -1.0f);
+    }
+
 private:
 
+    // Side is +1 for planes with the inside at Dot() >= 0 and -1 for those at Dot() <= 0.
+    // Only the corner furthest towards the inside needs to be tested.
+    static bool IsAABBInsidePlane(const Vector4f& Plane, const Vector3f& Min, const Vector3f& Max, float Side)
+    {
+        Vector4f Corner((Plane.x * Side >= 0.0f) ? Max.x : Min.x,
+                        (Plane.y * Side >= 0.0f) ? Max.y : Min.y,
+                        (Plane.z * Side >= 0.0f) ? Max.z : Min.z,
+                        1.0f);
+
+        return Plane.Dot(Corner) * Side >= 0.0f;
+    }
+
     Vector4f m_leftClipPlane;
     Vector4f m_rightClipPlane;
     Vector4f m_bottomClipPlane;
@@ -2,35 +2,49 @@
 #define MESH_HPP
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <thread>
+#include <vector>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp> // For transformations like perspective, lookAt, etc.
+#include <glm/gtc/packing.hpp>
 
 #include <assimp/Importer.hpp>  // C++ importer interface
 #include <assimp/scene.h>       // Output data structure
 #include <assimp/postprocess.h> // Post processing flags
 
+// Optional: run.sh defines GFX_USE_MESHOPTIMIZER and links the system library when the header is
+// installed. Without it LoadOptions::Optimize and GenerateLods are ignored.
+#ifdef GFX_USE_MESHOPTIMIZER
+#if !__has_include(<meshoptimizer.h>)
+#error "GFX_USE_MESHOPTIMIZER is defined but meshoptimizer.h is not on the include path"
+#endif
+#include <meshoptimizer.h>
+#endif
+
 #include "camera.hpp"
+#include "debugDraw.hpp"
+#include "importProfile.hpp"
+#include "lightingTechnique.hpp"
 #include "math3d.hpp"
 #include "material.hpp"
+#include "meshCache.hpp"
 #include "meshData.hpp"
+#include "textureCache.hpp"
+#include "threadPool.hpp"
+#include "triangleView.hpp"
 #include "utils.hpp"
 
 #define ARRAY_SIZE_IN_ELEMENTS(a) (sizeof(a)/sizeof(a[0]))
-#define ASSIMP_LOAD_FLAGS (aiProcess_JoinIdenticalVertices |    \
-                           aiProcess_Triangulate |              \
-                           aiProcess_GenSmoothNormals |         \
-                           aiProcess_LimitBoneWeights |         \
-                           aiProcess_SplitLargeMeshes |         \
-                           aiProcess_ImproveCacheLocality |     \
-                           aiProcess_RemoveRedundantMaterials | \
-                           aiProcess_FindDegenerates |          \
-                           aiProcess_FindInvalidData |          \
-                           aiProcess_GenUVCoords |              \
-                           aiProcess_CalcTangentSpace)
 
 #define GL_CHECK_ERROR() (glGetError() == GL_NO_ERROR)
 
@@ -38,15 +52,81 @@ class Mesh
 {
 public:
    
+    enum VERTEX_FORMAT {
+        VERTEX_FORMAT_FLOAT = 0,     // 32-byte float vertices, 32-bit indices
+        VERTEX_FORMAT_QUANTIZED = 1  // 12-byte packed vertices, 16-bit indices where they fit
+    };
+
+    struct LoadOptions {
+        bool Async = false; // stream sub-meshes in through update() instead of blocking
+        VERTEX_FORMAT VertexFormat = VERTEX_FORMAT_FLOAT;
+        bool Optimize = false; // meshoptimizer vertex-cache, overdraw and vertex-fetch pass per sub-mesh
+        bool GenerateLods = false; // simplified levels per sub-mesh, picked by screen-space error in render()
+        bool KeepCpuGeometry = true; // keep m_vertices/m_indices after upload for getTriangles()
+        IMPORT_PROFILE ImportProfile = IMPORT_PROFILE_RENDER_QUALITY;
+        bool TimeImportSteps = false; // apply post-process steps one by one and print their cost
+    };
+
     Mesh();
     ~Mesh();
     
     glm::mat4 computeTransform(const MeshData& mesh);
     void drawNormals(float normalLength);
-    void drawTriangles(GLuint wireframeProgram, const glm::mat4& mvp);
-    bool loadMesh(const std::string& filename);
+    void drawTriangles(DebugDraw& debugDraw, const glm::mat4& model);
+    bool loadMesh(const std::string& filename) { return loadMesh(filename, LoadOptions()); }
+    bool loadMesh(const std::string& filename, const LoadOptions& options);
     void processNode(aiNode* node, const aiScene* scene, int level = 0);
-    void render(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection, bool toggle);
+
+    static void benchmarkHierarchy(unsigned int maxNodes);
+    void render(LightingTechnique& technique, const glm::mat4& view, const glm::mat4& projection, bool toggle);
+    // Same image as render() with one glMultiDrawElementsIndirect per index type. Needs a
+    // LightingTechnique created with indirect = true and a GL 4.3 context.
+    void renderIndirect(LightingTechnique& technique, const glm::mat4& view, const glm::mat4& projection, bool toggle);
+
+    // Uploads whatever an asynchronous load has produced since the last call. GL thread only.
+    // Returns true while a load is in progress.
+    bool update();
+
+    enum LOAD_STATE {
+        LOAD_IDLE = 0,
+        LOAD_IN_PROGRESS = 1,
+        LOAD_DONE = 2,
+        LOAD_FAILED = 3
+    };
+
+    LOAD_STATE getLoadState() const { return m_loadState; }
+    float getLoadProgress() const;
+    VERTEX_FORMAT getVertexFormat() const { return m_vertexFormat; }
+
+    // Empty once the load released its CPU-side geometry, see LoadOptions::KeepCpuGeometry
+    TriangleView getTriangles() const;
+
+    bool hasLods() const { return m_generateLods; }
+    float getLodPixelError() const { return m_lodPixelError; }
+    void setLodPixelError(float pixels) { m_lodPixelError = pixels; }
+    // Draws per level during the last render(), index 0 is full resolution
+    const std::array<uint, MAX_LODS + 1>& getLodDrawCounts() const { return m_lodDrawCounts; }
+
+    // Spin of the animated joint in degrees; moves the local transforms below it through
+    // setLocalTransform(), so only those are recomputed, and only when the angle changed
+    float getAnimationAngle() const { return m_animationAngle; }
+    void setAnimationAngle(float degrees);
+
+    // Replaces a sub-mesh's local transform and marks it for the next transform pass. Only takes
+    // effect once the load finished and the hierarchy is flattened.
+    void setLocalTransform(uint meshIndex, const glm::mat4& transform);
+
+    // CPU time of the world transform pass during the last render(), and how many nodes it recomputed
+    double getTransformUpdateMs() const { return m_transformUpdateMs; }
+    uint getNumTransformsUpdated() const { return m_numTransformsUpdated; }
+    // Indices submitted during the last render(), an upper bound on vertex shader invocations
+    uint64_t getNumIndicesDrawn() const { return m_numIndicesDrawn; }
+
+    bool getFrustumCulling() const { return m_frustumCulling; }
+    void setFrustumCulling(bool enabled) { m_frustumCulling = enabled; }
+    // Sub-meshes submitted and rejected by the frustum test during the last render()
+    uint getNumDrawnMeshes() const { return m_numDrawnMeshes; }
+    uint getNumCulledMeshes() const { return m_numCulledMeshes; }
 
 protected:
     enum BUFFER_TYPE {
@@ -54,7 +134,10 @@ protected:
         VERTEX_BUFFER = 1,
         WVP_MAT_BUFFER = 2,  // required only for instancing
         WORLD_MAT_BUFFER = 3,  // required only for instancing
-        NUM_BUFFERS = 4
+        DRAW_COMMAND_BUFFER = 4,  // DrawElementsIndirectCommand per ready sub-mesh, renderIndirect() only
+        DRAW_DATA_BUFFER = 5,     // DrawData per sub-mesh, renderIndirect() only
+        DRAW_ID_BUFFER = 6,       // sub-mesh index per instance, renderIndirect() only
+        NUM_BUFFERS = 7
     };
 
     struct Vertex {
@@ -63,13 +146,78 @@ protected:
         Vector3f normal;
     };
 
-    struct Triangle {
-        glm::vec3 v0, v1, v2;
+    // Dequantized in the vertex shader, see lightingTechnique.cpp
+    struct QuantizedVertex {
+        uint16_t position[3];  // unorm16 relative to the sub-mesh AABB
+        int8_t normal[2];      // octahedral, snorm8 (about one degree of error)
+        uint16_t texCoords[2]; // half floats
+    };
+
+    // One MeshData in the flattened hierarchy. Nodes are stored parents first, so a single
+    // forward pass sees every parent's world transform before its children need it.
+    struct TransformNode {
+        uint MeshIndex = 0;
+        int Parent = -1;                          // index into m_transformNodes, -1 for roots
+        bool Animated = false;                    // below the "A0" joint, spins with m_animationAngle
+        bool Dirty = true;                        // Local changed since the last pass, see setLocalTransform()
+        bool Changed = false;                     // world transform recomputed in the current pass
+        glm::mat4 Bind = glm::mat4(1.0f);         // MeshData::getTransform()
+        glm::mat4 Local = glm::mat4(1.0f);        // Bind, times the spin for animated nodes
+        glm::mat4 InvParentBind = glm::mat4(1.0f); // inverse of the parent's Bind
+        glm::mat4 World = glm::mat4(1.0f);
+        glm::mat3 Normal = glm::mat3(1.0f);       // inverse transpose of World, recomputed with it
+    };
+
+    // Per sub-mesh state read by the INDIRECT_DRAW shader, std430 layout
+    struct DrawData {
+        glm::mat4 Model;
+        glm::mat4 NormalMatrix; // upper 3x3 used, a std430 mat3 would pad its columns anyway
+        glm::vec4 Color;
+        glm::vec4 QuantMin;
+        glm::vec4 QuantExtent;
+    };
+
+    // Layout fixed by glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand {
+        uint Count;
+        uint InstanceCount;
+        uint FirstIndex;
+        int BaseVertex;
+        uint BaseInstance;
+    };
+
+    // Post-import stages, stored in the mesh cache so a warm load never mixes them up
+    enum PIPELINE_FLAG {
+        PIPELINE_OPTIMIZED = 1 << 0,
+        PIPELINE_LODS = 1 << 1
+    };
+
+    // Totals over all sub-meshes, sampled with a 16-entry FIFO cache
+    struct OptimizeStats {
+        uint64_t NumTriangles = 0;
+        uint64_t NumVertices = 0;
+        uint64_t TransformedBefore = 0;
+        uint64_t TransformedAfter = 0;
+        uint64_t FetchedBefore = 0;
+        uint64_t FetchedAfter = 0;
+        double Ms = 0.0;
+    };
+
+    struct TextureJob {
+        Texture* pTexture = NULL;
+        const aiTexture* paiTexture = NULL;
+        const char* Kind = "";
+        int MaterialIndex = 0;
+        bool Decoded = false;
+        double DecodeMs = 0.0;
+        double UploadMs = 0.0;
     };
 
     Camera *m_camera;
     const aiScene* m_pScene;
     Assimp::Importer m_importer;
+    ImportProgressHandler* m_pImportProgress = nullptr; // owned by m_importer
+    MeshCache m_cache;
     std::vector<MeshData> m_meshes;
     Matrix4f m_globalInverseTransform;
 
@@ -77,22 +225,121 @@ protected:
     GLuint m_buffers[NUM_BUFFERS] = { 0 };
 
     void clear();
-    void extractTrianglesFromScene();
     virtual void reserveSpace(uint NumVertices, uint NumIndices);
     virtual void initSingleMesh(const aiMesh* paiMesh);
     virtual void populateBuffers();
+    void allocateBuffers();
+    void uploadSubMesh(const MeshData& mesh);
+    void setupVertexFormat();
 
 private:
     std::vector<uint> m_indices;
     std::vector<Vertex> m_vertices;
     std::vector<Material> m_materials;
-    std::vector<Triangle> m_triangles;
+    std::unordered_map<std::string, uint> m_meshIndexByName;
+    bool m_printHierarchy = true;
+    std::vector<TextureJob> m_textureJobs;
+    std::unique_ptr<ThreadPool> m_pTexturePool;
+    std::chrono::steady_clock::time_point m_textureDecodeStart;
+    double m_textureDecodeWallMs = 0.0;
+    unsigned int m_textureDecodeThreads = 0;
+
+    // Geometry handed to the GPU, either m_vertices/m_indices or the mapped cache file
+    const Vertex* m_pSourceVertices = nullptr;
+    const uint* m_pSourceIndices = nullptr;
+    uint m_numVertices = 0;
+    uint m_numIndices = 0;
+
+    // GPU-side layout. With VERTEX_FORMAT_QUANTIZED the packed copies below are what gets uploaded
+    VERTEX_FORMAT m_vertexFormat = VERTEX_FORMAT_FLOAT;
+    std::vector<QuantizedVertex> m_quantizedVertices;
+    std::vector<unsigned char> m_packedIndices;
+    size_t m_vertexBufferBytes = 0;
+    size_t m_indexBufferBytes = 0;
+
+    bool m_optimizeMeshes = false;
+    OptimizeStats m_optimizeStats;
+
+    IMPORT_PROFILE m_importProfile = IMPORT_PROFILE_RENDER_QUALITY;
+    bool m_timeImportSteps = false;
+    std::vector<ImportProfile::StepTiming> m_importStepTimings;
+
+    bool m_keepCpuGeometry = true;
+    bool m_generateLods = false;
+    float m_lodPixelError = 1.0f; // coarsest level whose projected error stays below this is drawn
+    std::array<uint, MAX_LODS + 1> m_lodDrawCounts = {};
+
+    float m_animationAngle = 0.0f;  // degrees, set by the simulation before each render()
+    std::vector<TransformNode> m_transformNodes;
+    std::vector<uint> m_transformNodeOfMesh;
+    double m_transformUpdateMs = 0.0;
+    uint m_numTransformsUpdated = 0;
+
+    bool m_frustumCulling = true;
+    uint m_numDrawnMeshes = 0;
+    uint64_t m_numIndicesDrawn = 0;
+    uint m_numCulledMeshes = 0;
+
+    // Rebuilt every renderIndirect(). Commands are grouped by index type, 32-bit ones first
+    std::vector<DrawData> m_drawData;
+    std::vector<DrawElementsIndirectCommand> m_drawCommands;
+    std::vector<DrawElementsIndirectCommand> m_drawCommands16;
+    bool m_indirectBuffersAllocated = false;
+
+    // Load pipeline state. The loader thread publishes under m_loadMutex, the GL thread consumes in update()
+    std::thread m_loadThread;
+    std::mutex m_loadMutex;
+    std::vector<uint> m_readyMeshes;
+    std::string m_loadFileName;
+    std::chrono::steady_clock::time_point m_loadStart;
+    LOAD_STATE m_loadState = LOAD_IDLE;
+    bool m_layoutReady = false;
+    bool m_importFinished = false;
+    bool m_importResult = false;
+    bool m_buffersAllocated = false;
+    bool m_uploadFailed = false; // a GL error followed one of update()'s uploads
+    bool m_loadedFromCache = false;
+    uint m_numUploadedMeshes = 0;
+
+    bool loadMeshAsync(const std::string& filename, const LoadOptions& options);
+    void beginLoad(const LoadOptions& options);
+    bool importModel(const std::string& filename);
+    void finishLoad(const std::string& filename, bool result);
+    void publishLayout();
+    void publishSubMesh(uint meshIndex);
+    void prepareLayout();
+    void prepareSubMesh(uint meshIndex);
+    void printVertexFormatStats() const;
+    void releaseSourceGeometry();
+    uint32_t getPipelineFlags() const;
+    unsigned int getImportFlags() const;
+    void optimizeSubMesh(uint meshIndex);
+    void printOptimizeStats() const;
+    uint getLodIndexCapacity(uint numIndices) const;
+    void generateLods(uint meshIndex);
+    uint selectLod(const MeshData& mesh, const glm::mat4& transform, const glm::vec3& cameraPos, float pixelsPerUnit) const;
+    void buildTransformHierarchy();
+    glm::mat4 getAnimationSpin() const;
+    void updateTransforms();
+    glm::mat4 getWorldTransform(uint meshIndex);
+    glm::mat3 getNormalMatrix(uint meshIndex, const glm::mat4& transform) const;
+    bool cullSubMesh(MeshData& mesh, const glm::mat4& transform, const FrustumCulling& frustum);
+    void getDrawRange(const MeshData& mesh, uint level, uint& numIndices, size_t& indexByteOffset) const;
+    glm::vec3 getObjectColor(const MeshData& mesh, bool toggle) const;
+    void allocateIndirectBuffers();
 
+    bool initFromCache(const MeshCache& cache);
     bool initScene(const aiScene* pScene, const std::string& filename);
     bool initMaterials(const aiScene* pScene, const std::string& filename);
+    void buildNameIndex();
+    MeshData* findMeshByName(const aiString& name);
     void countVerticesAndIndices(aiNode* node, const aiScene* scene, unsigned int& numVertices, unsigned int& numIndices, const aiMatrix4x4& parentTransform);
     
     void loadColors(const aiMaterial* pMaterial, int index);
+    std::shared_ptr<Texture> acquireTexture(const aiTexture* paiTexture, const std::string& fullPath, const char* kind, int materialIndex);
+    void decodeTextures();
+    void waitForTextures();
+    void uploadTextures();
     void loadTextures(const std::string& Dir, const aiMaterial* pMaterial, int index);
 
     void loadDiffuseTexture(const std::string& Dir, const aiMaterial* pMaterial, int index);
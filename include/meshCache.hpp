@@ -0,0 +1,110 @@
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "math3d.hpp"
+#include "material.hpp"
+#include "meshData.hpp"
+#include "utils.hpp"
+
+// On-disk snapshot of a fully processed mesh. A warm load maps the file and hands
+// the vertex/index sections straight to the GPU without going through Assimp.
+//
+// Layout: Header | MeshRecord[NumMeshes] | MaterialRecord[NumMaterials] | names | vertices | indices
+class MeshCache
+{
+public:
+    static const uint32_t MAGIC = 0x48534d47; // "GMSH"
+    static const uint32_t VERSION = 4;
+
+    struct SourceInfo {
+        uint64_t Size = 0;
+        int64_t MTime = 0;
+        uint64_t Hash = 0;
+    };
+
+    struct Header {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t LoadFlags;
+        uint32_t PipelineFlags; // post-import stages the geometry went through, see Mesh::getPipelineFlags()
+        uint32_t VertexStride;
+        uint32_t Reserved;
+        uint64_t SourceSize;
+        int64_t SourceMTime;
+        uint64_t SourceHash;
+        uint32_t NumMeshes;
+        uint32_t NumMaterials;
+        uint32_t NumVertices;
+        uint32_t NumIndices;
+        uint64_t NamesOffset;
+        uint64_t VerticesOffset;
+        uint64_t IndicesOffset;
+        uint64_t FileSize;
+    };
+
+    struct MeshRecord {
+        uint32_t NameOffset;
+        uint32_t NameLength;
+        int32_t Parent;
+        uint32_t NumIndices;
+        uint32_t NumVertices;
+        uint32_t BaseVertex;
+        uint32_t BaseIndex;
+        uint32_t MaterialIndex;
+        uint32_t LodIndexCapacity;
+        uint32_t NumLods;
+        uint32_t LodBaseIndex[MAX_LODS];
+        uint32_t LodNumIndices[MAX_LODS];
+        float LodError[MAX_LODS];
+        float Transform[16];
+    };
+
+    struct MaterialRecord {
+        float Ambient[4];
+        float Diffuse[4];
+        float Specular[4];
+    };
+
+    MeshCache();
+    ~MeshCache();
+
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    static std::string getCachePath(const std::string& sourceFile);
+    // Size and modification time only, cheap enough for every load
+    static bool describeSource(const std::string& sourceFile, SourceInfo& info);
+    // Fills info.Hash from the file contents
+    static bool hashSource(const std::string& sourceFile, SourceInfo& info);
+    static bool write(const std::string& cachePath, const SourceInfo& source, uint32_t loadFlags, uint32_t pipelineFlags,
+                      const std::vector<MeshData>& meshes, const std::vector<Material>& materials,
+                      const void* pVertices, uint32_t numVertices, uint32_t vertexStride,
+                      const uint32_t* pIndices, uint32_t numIndices);
+
+    // Maps the cache file and validates its layout and the source, load and pipeline flags.
+    // The source is hashed into source.Hash only when its size or time differ from the header.
+    bool open(const std::string& cachePath, const std::string& sourceFile, SourceInfo& source,
+              uint32_t loadFlags, uint32_t pipelineFlags, uint32_t vertexStride);
+    void close();
+    bool isOpen() const { return m_pData != nullptr; }
+
+    const Header& getHeader() const { return *reinterpret_cast<const Header*>(m_pData); }
+    const MeshRecord* getMeshes() const;
+    const MaterialRecord* getMaterials() const;
+    std::string getName(const MeshRecord& record) const;
+    const void* getVertices() const;
+    const uint32_t* getIndices() const;
+
+private:
+    bool validateLayout() const;
+    static bool updateSourceMTime(const std::string& cachePath, int64_t mtime);
+
+    const unsigned char* m_pData = nullptr;
+    size_t m_size = 0;
+};
+
+#endif // MESH_CACHE_HPP
@@ -1,21 +1,33 @@
+#ifndef MESH_DATA_HPP
+#define MESH_DATA_HPP
+
 #include <algorithm>
 #include <string>
 #include <sstream>
 #include <vector>
 
 #include <assimp/scene.h>
+#include <glm/glm.hpp>
 
 #define INVALID_MATERIAL 0xFFFFFFFF
+#define MAX_LODS 3
 
 class MeshData
 {
 public:
+    struct Lod {
+        uint BaseIndex = 0;  // absolute, inside the slots reserved after the full-resolution range
+        uint NumIndices = 0;
+        float Error = 0.0f;  // mesh-space deviation from the full-resolution surface
+    };
+
     MeshData()
     {
         Name = "";
         Parent = nullptr;
         Children = std::vector<MeshData*>();
         NumIndices = 0;
+        NumVertices = 0;
         BaseVertex = 0;
         BaseIndex = 0;
         MaterialIndex = INVALID_MATERIAL;
@@ -26,10 +38,23 @@ public:
     MeshData* Parent;
     std::vector<MeshData*> Children;
     uint NumIndices;
+    uint NumVertices;
     uint BaseVertex;
     uint BaseIndex;
     uint MaterialIndex;
     aiMatrix4x4 Transform;
+    bool Ready = false; // set once the sub-mesh data is resident on the GPU
+    glm::vec3 AABBMin = glm::vec3(0.0f); // mesh-space bounds, also the quantization range
+    glm::vec3 AABBMax = glm::vec3(0.0f);
+    glm::vec3 WorldAABBMin = glm::vec3(0.0f); // AABBMin/AABBMax under the transform of the last render
+    glm::vec3 WorldAABBMax = glm::vec3(0.0f);
+    uint IndexSize = sizeof(uint);       // 2 or 4 bytes depending on the vertex format
+    size_t IndexByteOffset = 0;          // start of this sub-mesh in the index buffer
+    std::vector<Lod> Lods;               // simplified levels, coarser with each entry
+    uint LodIndexCapacity = 0;           // index slots reserved for Lods right after the full-resolution range
+
+    // Index count of the whole range owned by this sub-mesh, full resolution plus LOD slots
+    uint getIndexRange() const { return NumIndices + LodIndexCapacity; }
 
     std::string printPosition()
     {
@@ -95,4 +120,6 @@ public:
         if (it != meshes.end()) { return &(*it); } 
         else { return nullptr; }
     }
-};
\ No newline at end of file
+};
+
+#endif // MESH_DATA_HPP
@@ -0,0 +1,42 @@
+#ifndef OFFSCREEN_TARGET_HPP
+#define OFFSCREEN_TARGET_HPP
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Multisampled color and depth framebuffer for rendering without a window. savePng() resolves
+// it into a single-sampled RGBA8 framebuffer, reads the pixels back and writes them with
+// stb_image_write.
+class OffscreenTarget
+{
+public:
+    OffscreenTarget() {}
+    ~OffscreenTarget();
+
+    // samples is clamped to GL_MAX_SAMPLES, 1 or less renders without multisampling
+    bool init(int width, int height, int samples);
+
+    // Makes the target the draw framebuffer and covers it with the viewport
+    void bind() const;
+
+    bool savePng(const std::string& path);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    int getSamples() const { return m_samples; }
+
+private:
+    GLuint m_FBO = 0;
+    GLuint m_colorRBO = 0;
+    GLuint m_depthRBO = 0;
+    GLuint m_resolveFBO = 0;
+    GLuint m_resolveRBO = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_samples = 0;
+    std::vector<unsigned char> m_pixels;
+};
+
+#endif // OFFSCREEN_TARGET_HPP
@@ -0,0 +1,74 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <chrono>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+// Per-pass CPU and GPU frame timings. Each scope records wall time on the CPU and a
+// GL_TIME_ELAPSED query on the GPU. Queries are double-buffered: a frame's results are
+// collected two frames later, and only if they are already available, so reading them never
+// stalls the pipeline. Elapsed-time queries cannot nest, so neither can scopes.
+class Profiler
+{
+public:
+    static const uint32_t MAX_SCOPES = 16;
+    static const uint32_t HISTORY_SIZE = 240; // frames kept for the frame-time graph
+
+    // Times the enclosing block as one pass
+    class Scope
+    {
+    public:
+        Scope(Profiler& profiler, const char* pName) : m_profiler(profiler) { m_profiler.beginScope(pName); }
+        ~Scope() { m_profiler.endScope(); }
+
+    private:
+        Profiler& m_profiler;
+    };
+
+    Profiler() {}
+    ~Profiler();
+
+    bool init();
+
+    void beginFrame();
+    void endFrame();
+
+    // pName must outlive the profiler, string literals are expected
+    void beginScope(const char* pName);
+    void endScope();
+
+    // Rolling frame-time graph and per-pass table, drawn into the current ImGui window
+    void drawGui() const;
+
+private:
+    static const uint32_t NUM_QUERY_FRAMES = 2;
+
+    struct ScopeStats {
+        const char* pName = nullptr;
+        float CpuMs = 0.0f;
+        float GpuMs = 0.0f;
+        float AvgCpuMs = 0.0f; // exponential moving averages, steadier to read
+        float AvgGpuMs = 0.0f;
+    };
+
+    void collectGpuResults(uint32_t queryFrame);
+
+    GLuint m_queries[NUM_QUERY_FRAMES][MAX_SCOPES] = {};
+    bool m_queryIssued[NUM_QUERY_FRAMES][MAX_SCOPES] = {};
+    ScopeStats m_scopes[MAX_SCOPES];
+    uint32_t m_numScopes = 0;
+    int m_activeScope = -1;
+
+    uint64_t m_frame = 0;
+    std::chrono::steady_clock::time_point m_frameStart;
+    std::chrono::steady_clock::time_point m_scopeStart;
+    bool m_frameStarted = false;
+
+    float m_frameMs[HISTORY_SIZE] = {};
+    uint32_t m_historyOffset = 0;
+    float m_maxFrameMs = 0.0f;
+};
+
+#endif // PROFILER_HPP
@@ -0,0 +1,71 @@
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "utils.hpp"
+
+// On-disk cache of linked program binaries (glGetProgramBinary). Technique::Finalize keys
+// each program by the hash of its shader sources seeded with getDriverHash(), so a driver
+// update or a different GPU simply misses. A file with a bad header and a binary the driver
+// rejects on load are counted apart; either way the program is compiled from source and
+// stored again.
+//
+// Layout: Header | binary
+class ProgramCache
+{
+public:
+    static const uint32_t MAGIC = 0x47525047; // "GPRG"
+    static const uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t Magic;
+        uint32_t Version;
+        uint64_t Key;
+        uint32_t BinaryFormat;
+        uint32_t BinaryLength;
+    };
+
+    static ProgramCache& instance();
+
+    // Disabled when the driver offers no binary formats, or from the command line
+    bool isEnabled();
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+
+    // Vendor, renderer and version strings of the current context
+    uint64_t getDriverHash();
+
+    // Loads the binary stored under key into program; true when the program is linked afterwards
+    bool load(GLuint program, uint64_t key);
+    // Stores the binary of a linked program, which must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    bool store(GLuint program, uint64_t key);
+
+    // Main-thread time spent producing a linked program, by where it came from. For a compile
+    // that is the time to issue it plus the wait for the link in Technique::Complete().
+    void addLoadTime(double ms) { m_loadMs += ms; }
+    void addCompileTime(double ms) { m_compileMs += ms; m_compiled++; }
+
+    void printStats();
+
+private:
+    ProgramCache() {}
+
+    static std::string getCachePath(uint64_t key);
+
+    bool m_enabled = true;
+    bool m_formatsChecked = false;
+    bool m_driverHashed = false;
+    uint64_t m_driverHash = 0;
+
+    uint32_t m_hits = 0;
+    uint32_t m_compiled = 0;
+    uint32_t m_rejected = 0; // well-formed binaries the driver refused in glProgramBinary
+    uint32_t m_invalid = 0;  // files that failed to read or did not match the header
+    double m_loadMs = 0.0;
+    double m_compileMs = 0.0;
+};
+
+#endif // PROGRAM_CACHE_HPP
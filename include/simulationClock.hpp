@@ -0,0 +1,49 @@
+#ifndef SIMULATION_CLOCK_HPP
+#define SIMULATION_CLOCK_HPP
+
+#include <chrono>
+
+// Monotonic frame clock driving a fixed-timestep simulation. advance() is called once per
+// frame and returns how many fixed steps to simulate; the leftover fraction of a step is
+// exposed as getAlpha() so rendering can blend the last two simulated states. Pausing and
+// scaling only affect simulated time, frame time keeps running.
+class SimulationClock
+{
+public:
+    explicit SimulationClock(double fixedStep = 0.01);
+
+    // Samples the frame clock and returns the number of fixed steps that became due
+    int advance();
+    // Same, with the frame time given instead of measured, for deterministic offline rendering
+    int advanceBy(double frameSeconds);
+
+    double getFixedStep() const { return m_fixedStep; }
+    // Position between the previous and the current simulated state, in [0, 1)
+    float getAlpha() const { return static_cast<float>(m_accumulator / m_fixedStep); }
+
+    double getFrameSeconds() const { return m_frameSeconds; }     // unscaled wall time of the last frame
+    double getElapsedSeconds() const { return m_elapsedSeconds; } // unscaled wall time since start
+    double getSimulationTime() const { return m_simulationTime; } // simulated seconds, including the alpha fraction
+
+    bool isPaused() const { return m_paused; }
+    void setPaused(bool paused) { m_paused = paused; }
+
+    float getTimeScale() const { return m_timeScale; }
+    void setTimeScale(float scale) { m_timeScale = scale < 0.0f ? 0.0f : scale; }
+
+private:
+    // A long stall (debugger, window drag, loading) is not caught up step by step
+    static constexpr double MAX_FRAME_SECONDS = 0.25;
+    static const int MAX_STEPS_PER_FRAME = 16;
+
+    std::chrono::steady_clock::time_point m_lastFrame;
+    double m_fixedStep;
+    double m_accumulator = 0.0;
+    double m_frameSeconds = 0.0;
+    double m_elapsedSeconds = 0.0;
+    double m_simulationTime = 0.0;
+    float m_timeScale = 1.0f;
+    bool m_paused = false;
+};
+
+#endif // SIMULATION_CLOCK_HPP
@@ -3,6 +3,8 @@
 
 #include <list>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <GL/glew.h>
 
 #include "utils.hpp"
@@ -20,26 +22,70 @@ public:
 
     virtual bool Init();
 
-    void Enable();
+    // With deferred completion Finalize() only issues the compile and link, and the link result
+    // is collected by Complete(), at the latest on the first Enable(). Set before Init().
+    void SetDeferredCompletion(bool Deferred) { m_deferCompletion = Deferred; }
+
+    // Waits for a pending link and runs the post-link setup; true when the program is usable
+    bool Complete();
+
+    // False when the program failed to build, nothing is bound then
+    bool Enable();
 
     GLuint GetProgram() const { return m_shaderProg; }
 
+    // Lets the driver compile and link on its own threads (GL_KHR_parallel_shader_compile).
+    // Call once the context is current; false when the driver has no such extension.
+    static bool EnableParallelCompile();
+
 protected:
 
     bool AddShader(GLenum ShaderType, const char* pFilename);
 
+    bool AddShaderSource(GLenum ShaderType, const char* pSource, const char* pName);
+
     bool Finalize();
 
+    // Uniform locations and other queries that need the linked program, run once by Complete()
+    virtual bool OnLinked() { return true; }
+
     GLint GetUniformLocation(const char* pUniformName);
 
     GLuint m_shaderProg = 0;
 
 private:
 
+    enum LINK_STATE {
+        LINK_NONE,
+        LINK_PENDING, // compile and link issued, status not queried yet
+        LINK_DONE,
+        LINK_FAILED
+    };
+
+    bool IssueCompileAndLink();
+
+    void PrintCompileErrors();
+
     void PrintUniformList();
 
+    // Sources are only compiled in Finalize(), and not at all when the program cache has the binary
+    struct ShaderSource {
+        GLenum Type;
+        std::string Source;
+        std::string Name;
+    };
+
+    std::vector<ShaderSource> m_shaderSources;
+    std::vector<std::string> m_shaderNames; // of the objects in m_shaderObjList, for compile errors
+
     typedef std::list<GLuint> ShaderObjList;
     ShaderObjList m_shaderObjList;
+
+    LINK_STATE m_linkState = LINK_NONE;
+    bool m_deferCompletion = false;
+    bool m_fromCache = false;
+    uint64_t m_cacheKey = 0;
+    double m_issueMs = 0.0; // time spent issuing the compile, added to the wait in Complete()
 };
 
 #ifdef FAIL_ON_MISSING_LOC                  
@@ -20,6 +20,8 @@ public:
 
     Texture(GLenum TextureTarget, const std::string& FileName);
 
+    ~Texture();
+
     // Should be called once to load the texture
     bool Load();
 
@@ -31,6 +33,23 @@ public:
 
     void LoadF32(int Width, int Height, const float* pImageData);
 
+    // Decode into CPU memory without touching GL state, so it can run on a worker thread
+    bool Decode();
+
+    bool Decode(unsigned int BufferSize, const void* pData);
+
+    // Uploads the decoded image and releases the CPU copy. GL thread only.
+    void Upload();
+
+    bool IsDecoded() const { return m_pDecodedData != NULL; }
+
+    const std::string& GetFileName() const { return m_fileName; }
+
+    int GetBPP() const { return m_imageBPP; }
+
+    // GPU memory used by the texture and its mip chain
+    size_t GetResidentBytes() const;
+
     // Must be called at least once for the specific texture unit
     void Bind(GLenum TextureUnit);
 
@@ -46,16 +65,18 @@ private:
     void LoadInternal(const void* pImageData);
     void LoadInternalNonDSA(const void* pImageData);
     void LoadInternalDSA(const void* pImageData);    
+    int GetNumLevels() const;
 
     void BindInternalNonDSA(GLenum TextureUnit);
     void BindInternalDSA(GLenum TextureUnit);
 
     std::string m_fileName;
     GLenum m_textureTarget;
-    GLuint m_textureObj;
+    GLuint m_textureObj = 0;
     int m_imageWidth = 0;
     int m_imageHeight = 0;
     int m_imageBPP = 0;
+    unsigned char* m_pDecodedData = NULL;
 };
 
 #endif  /* TEXTURE_H */
@@ -0,0 +1,48 @@
+#ifndef TEXTURE_CACHE_HPP
+#define TEXTURE_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <GL/glew.h>
+#include <assimp/scene.h>
+
+#include "texture.hpp"
+#include "utils.hpp"
+
+// Process-wide registry of loaded textures. Textures are keyed by resolved file path
+// or by a hash of the embedded image bytes, and handed out as shared handles so every
+// material (in every loaded model) that references the same image shares one GL texture.
+class TextureCache
+{
+public:
+    static TextureCache& instance();
+
+    static std::string keyForFile(const std::string& fullPath);
+    static std::string keyForEmbedded(const aiTexture* paiTexture);
+
+    // Returns the texture registered under key, creating an empty one on a miss.
+    // isNew is set when the caller is responsible for decoding and uploading it.
+    std::shared_ptr<Texture> acquire(const std::string& key, GLenum textureTarget, const std::string& fileName, bool& isNew);
+
+    uint64_t getHits() const { return m_hits; }
+    uint64_t getMisses() const { return m_misses; }
+    size_t getNumTextures();
+    size_t getResidentBytes();
+
+    void printStats();
+
+private:
+    TextureCache() {}
+
+    std::unordered_map<std::string, std::weak_ptr<Texture>> m_textures;
+    std::mutex m_mutex;
+    std::atomic<uint64_t> m_hits = 0;
+    std::atomic<uint64_t> m_misses = 0;
+};
+
+#endif // TEXTURE_CACHE_HPP
@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling jobs from a shared FIFO queue.
+// Jobs must not touch GL state; only the thread owning the context may do that.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> job);
+
+    // Blocks until the queue is empty and no job is running
+    void wait();
+
+    size_t getPendingJobs();
+    unsigned int getNumThreads() const { return static_cast<unsigned int>(m_workers.size()); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_jobsDone;
+    unsigned int m_activeJobs = 0;
+    bool m_stopping = false;
+};
+
+#endif // THREAD_POOL_HPP
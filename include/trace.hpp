@@ -0,0 +1,56 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Offline timeline capture in Chrome trace JSON, viewable in chrome://tracing or Perfetto.
+// Build with -DGFX_ENABLE_TRACING (GFX_TRACE=1 ./run.sh) to enable it; otherwise every
+// macro below expands to nothing and the instrumentation costs nothing.
+//
+//   TRACE_SCOPE("Mesh::render");     // complete event covering the enclosing block
+//   TRACE_THREAD_NAME("loader");     // label for the calling thread in the viewer
+//   TRACE_DUMP("trace.json");        // writes everything recorded so far
+//
+// Each thread appends to its own fixed-size buffer with no locking; the first event on a
+// thread registers its buffer once. Events past a buffer's capacity are dropped and counted.
+
+#ifdef GFX_ENABLE_TRACING
+
+namespace Trace
+{
+    uint64_t nowNs();
+    void record(const char* pName, uint64_t startNs, uint64_t endNs);
+    void setThreadName(const char* pName);
+    bool dump(const std::string& path);
+
+    class ScopedEvent
+    {
+    public:
+        explicit ScopedEvent(const char* pName) : m_pName(pName), m_startNs(nowNs()) {}
+        ~ScopedEvent() { record(m_pName, m_startNs, nowNs()); }
+
+    private:
+        const char* m_pName;
+        uint64_t m_startNs;
+    };
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(name)       Trace::ScopedEvent TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+#define TRACE_DUMP(path)        Trace::dump(path)
+
+#else
+
+#define TRACE_SCOPE(name)       do {} while (0)
+#define TRACE_THREAD_NAME(name) do {} while (0)
+#define TRACE_DUMP(path)        do {} while (0)
+
+#endif // GFX_ENABLE_TRACING
+
+#endif // TRACE_HPP
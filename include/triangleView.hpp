@@ -0,0 +1,80 @@
+#ifndef TRIANGLE_VIEW_HPP
+#define TRIANGLE_VIEW_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "meshData.hpp"
+
+// Non-owning view of the full-resolution triangles of a model. Positions are read in place
+// from the interleaved vertex array and corners are addressed through the index array, so
+// nothing is copied. The view is only valid while the arrays it points into are alive.
+class TriangleView
+{
+public:
+    TriangleView() {}
+
+    TriangleView(const float* pPositions, size_t vertexStride, const uint* pIndices, const std::vector<MeshData>* pMeshes)
+        : m_pPositions(reinterpret_cast<const unsigned char*>(pPositions)),
+          m_vertexStride(vertexStride),
+          m_pIndices(pIndices),
+          m_pMeshes(pMeshes)
+    {
+    }
+
+    bool empty() const { return m_pPositions == nullptr || m_pIndices == nullptr || m_pMeshes == nullptr; }
+
+    size_t getNumMeshes() const { return empty() ? 0 : m_pMeshes->size(); }
+    uint getNumTriangles(size_t meshIndex) const { return (*m_pMeshes)[meshIndex].NumIndices / 3; }
+
+    size_t getNumTriangles() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < getNumMeshes(); i++) {
+            count += getNumTriangles(i);
+        }
+        return count;
+    }
+
+    // Global vertex indices of the three corners, usable as keys by spatial structures
+    void getVertexIndices(size_t meshIndex, uint triangle, uint out[3]) const
+    {
+        const MeshData& mesh = (*m_pMeshes)[meshIndex];
+        const uint* pCorners = m_pIndices + mesh.BaseIndex + 3 * triangle;
+
+        out[0] = mesh.BaseVertex + pCorners[0];
+        out[1] = mesh.BaseVertex + pCorners[1];
+        out[2] = mesh.BaseVertex + pCorners[2];
+    }
+
+    glm::vec3 getPosition(uint vertexIndex) const
+    {
+        const float* p = reinterpret_cast<const float*>(m_pPositions + m_vertexStride * vertexIndex);
+        return glm::vec3(p[0], p[1], p[2]);
+    }
+
+    // Calls fn(meshIndex, v0, v1, v2) for every triangle, in mesh-space coordinates
+    template <typename Fn>
+    void forEach(Fn&& fn) const
+    {
+        for (size_t meshIndex = 0; meshIndex < getNumMeshes(); meshIndex++) {
+            uint numTriangles = getNumTriangles(meshIndex);
+
+            for (uint triangle = 0; triangle < numTriangles; triangle++) {
+                uint corners[3];
+                getVertexIndices(meshIndex, triangle, corners);
+                fn(meshIndex, getPosition(corners[0]), getPosition(corners[1]), getPosition(corners[2]));
+            }
+        }
+    }
+
+private:
+    const unsigned char* m_pPositions = nullptr;
+    size_t m_vertexStride = 0;
+    const uint* m_pIndices = nullptr;
+    const std::vector<MeshData>* m_pMeshes = nullptr;
+};
+
+#endif // TRIANGLE_VIEW_HPP
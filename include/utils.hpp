@@ -5,6 +5,7 @@
 #include <GL/glew.h>
 
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
@@ -32,6 +33,13 @@ namespace utils
         void printCurrentDirectory();
         void printFilesInCurrentDirectory();
         bool readFile(const char* pFileName, std::string& outFile);
+        bool readBinaryFile(const std::string& fileName, std::string& outData);
+    }
+
+    namespace hash
+    {
+        uint64_t fnv1a64(const void* pData, size_t size, uint64_t seed = 0xcbf29ce484222325ULL);
+        std::string toHex(uint64_t value);
     }
 
     namespace format
@@ -40,11 +48,6 @@ namespace utils
         void printBegin();
         void printEnd();
     }
-
-    namespace timer
-    {
-        void shutdown(int seconds,  bool* runIndifiitely);
-    }
 }
 
 #endif // UTILS_HPP
\ No newline at end of file
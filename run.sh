@@ -11,12 +11,27 @@ rm -f ./gfx ./gfx-debug
 # Create build directory for object files if it doesn't exist
 mkdir -p build/objects
 
+# GFX_TRACE=1 ./run.sh compiles in the Chrome trace instrumentation (see include/trace.hpp)
+EXTRA_FLAGS=""
+if [ "$GFX_TRACE" = "1" ]; then
+    EXTRA_FLAGS="-DGFX_ENABLE_TRACING"
+fi
+
+# The mesh optimization and LOD stages use the system meshoptimizer library when it is installed
+EXTRA_LIBS=""
+if echo '#include <meshoptimizer.h>' | g++ -x c++ -fsyntax-only - 2>/dev/null; then
+    EXTRA_FLAGS="$EXTRA_FLAGS -DGFX_USE_MESHOPTIMIZER"
+    EXTRA_LIBS="-lmeshoptimizer"
+else
+    echo "meshoptimizer not found, building without mesh optimization and LODs"
+fi
+
 # Compile all source files
 echo "Starting compilation..."
 start_time=$(date +%s.%N)
 for file in src/*.cpp; do
-    ccache g++ -std=c++20 -Wall -Wextra -g -c "$file" -o "build/objects/$(basename ${file%.cpp}.o)" \
-    -Iinclude -I3rdParty/imgui -I3rdParty/stb -I3rdParty/meshoptimizer/src -I/usr/include/eigen3 -I/usr/include/vendor/assimp-install/include
+    ccache g++ -std=c++20 -Wall -Wextra -g $EXTRA_FLAGS -c "$file" -o "build/objects/$(basename ${file%.cpp}.o)" \
+    -Iinclude -I3rdParty/imgui -I3rdParty/stb -I/usr/include/eigen3 -I/usr/include/vendor/assimp-install/include
     if [ $? -ne 0 ]; then
         echo "Compilation failed for $file"
         exit 1
@@ -33,7 +48,7 @@ start_time=$(date +%s.%N)
 ccache g++ -o gfx build/objects/*.o \
 -L. -Llib -L3rdParty/imgui -L/usr/include/vendor/assimp-install/lib \
 -L/usr/lib/x86_64-linux-gnu \
--limgui -lglfw -lGL -lGLU -ldl -lX11 -lpthread -lXrandr -lXi -lGLEW -lfmt -lfcl -lccd \
+-limgui -lglfw -lGL -lEGL -lGLU -ldl -lX11 -lpthread -lXrandr -lXi -lGLEW -lfmt -lfcl -lccd $EXTRA_LIBS \
 /usr/include/vendor/assimp-install/lib/libassimp.a -lz -lminizip -DGLEW_STATIC
 if [ $? -ne 0 ]; then
     echo "Linking failed"
@@ -41,10 +41,15 @@ void Camera::setWindow(GLFWwindow* window)
 
 void Camera::resetView()
 {
-    m_distance = 0.65f;  // Default distance from target
-    m_yaw = -90.0f;     // Default horizontal angle
-    m_pitch = 60.0f;     // Default vertical angle
-    m_target = glm::vec3(0.0f, 0.125f, 0.0f); // Default target
+    setOrbit(OrbitPose());
+}
+
+void Camera::setOrbit(const OrbitPose& pose)
+{
+    m_distance = pose.Distance;
+    m_yaw = pose.Yaw;
+    m_pitch = pose.Pitch;
+    m_target = pose.Target;
     updateCameraVectors();
 }
 
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cstring>
+
+#include "debugDraw.hpp"
+#include "utils.hpp"
+
+DebugDraw::~DebugDraw()
+{
+    for (GLsync& fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+
+    if (m_VBO != 0) {
+        glUnmapNamedBuffer(m_VBO);
+        glDeleteBuffers(1, &m_VBO);
+    }
+
+    if (m_VAO != 0) {
+        glDeleteVertexArrays(1, &m_VAO);
+    }
+}
+
+bool DebugDraw::init()
+{
+    // Only the compile is issued here, the link is collected on the first flush()
+    m_technique.SetDeferredCompletion(true);
+
+    if (!m_technique.Init()) {
+        return false;
+    }
+
+    GLsizeiptr bytes = sizeof(Vertex) * MAX_VERTICES * NUM_REGIONS;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &m_VBO);
+    glNamedBufferStorage(m_VBO, bytes, nullptr, flags);
+    m_pMapped = static_cast<Vertex*>(glMapNamedBufferRange(m_VBO, 0, bytes, flags));
+
+    if (m_pMapped == nullptr) {
+        return false;
+    }
+
+    glCreateVertexArrays(1, &m_VAO);
+    glVertexArrayVertexBuffer(m_VAO, 0, m_VBO, 0, sizeof(Vertex));
+
+    glEnableVertexArrayAttrib(m_VAO, 0);
+    glVertexArrayAttribFormat(m_VAO, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+    glVertexArrayAttribBinding(m_VAO, 0, 0);
+
+    glEnableVertexArrayAttrib(m_VAO, 1);
+    glVertexArrayAttribFormat(m_VAO, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, Color));
+    glVertexArrayAttribBinding(m_VAO, 1, 0);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+uint32_t DebugDraw::packColor(const glm::vec3& color)
+{
+    glm::vec3 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + glm::vec3(0.5f);
+
+    return static_cast<uint32_t>(c.r) | (static_cast<uint32_t>(c.g) << 8) | (static_cast<uint32_t>(c.b) << 16) | (0xFFu << 24);
+}
+
+// Counts count vertices against the frame budget; a primitive that does not fit is dropped
+bool DebugDraw::reserveVertices(uint32_t count)
+{
+    if (m_numQueued + count <= MAX_VERTICES) {
+        m_numQueued += count;
+        return true;
+    }
+
+    if (!m_overflowReported) {
+        printf(RED_TEXT "DebugDraw: more than %u vertices queued in a frame, the rest are dropped" RESET_TEXT "\n", MAX_VERTICES);
+        m_overflowReported = true;
+    }
+
+    return false;
+}
+
+void DebugDraw::addLine(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color, bool depthTest)
+{
+    if (!reserveVertices(2)) {
+        return;
+    }
+
+    uint32_t packed = packColor(color);
+    std::vector<Vertex>& lines = depthTest ? m_lines : m_overlayLines;
+
+    lines.push_back({ from, packed });
+    lines.push_back({ to, packed });
+}
+
+void DebugDraw::addPoint(const glm::vec3& position, const glm::vec3& color)
+{
+    if (!reserveVertices(1)) {
+        return;
+    }
+
+    m_points.push_back({ position, packColor(color) });
+}
+
+void DebugDraw::addTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& color)
+{
+    if (!reserveVertices(3)) {
+        return;
+    }
+
+    uint32_t packed = packColor(color);
+
+    m_triangles.push_back({ v0, packed });
+    m_triangles.push_back({ v1, packed });
+    m_triangles.push_back({ v2, packed });
+}
+
+void DebugDraw::flush()
+{
+    if (m_numQueued == 0) {
+        return;
+    }
+
+    // A program that failed to build was reported once when it was completed; drop the frame's primitives
+    if (!m_technique.Enable()) {
+        clearQueues();
+        return;
+    }
+
+    // The GPU may still read this region from NUM_REGIONS frames ago
+    GLsync& fence = m_fences[m_region];
+    if (fence) {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    GLint regionBase = static_cast<GLint>(m_region * MAX_VERTICES);
+    Vertex* pDest = m_pMapped + regionBase;
+    uint32_t used = 0;
+
+    // The queues fit the region together, see reserveVertices(); returns the first vertex of the range
+    auto append = [&](const std::vector<Vertex>& vertices, GLsizei& count) {
+        count = static_cast<GLsizei>(vertices.size());
+        if (count > 0) {
+            memcpy(pDest + used, vertices.data(), sizeof(Vertex) * count);
+        }
+
+        GLint first = regionBase + static_cast<GLint>(used);
+        used += count;
+        return first;
+    };
+
+    GLsizei numLineVertices, numOverlayVertices, numPointVertices, numTriangleVertices;
+    GLint firstLine = append(m_lines, numLineVertices);
+    GLint firstOverlay = append(m_overlayLines, numOverlayVertices);
+    GLint firstPoint = append(m_points, numPointVertices);
+    GLint firstTriangle = append(m_triangles, numTriangleVertices);
+
+    glBindVertexArray(m_VAO);
+
+    if (numLineVertices > 0) {
+        glDrawArrays(GL_LINES, firstLine, numLineVertices);
+    }
+
+    if (numOverlayVertices > 0) {
+        GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_DEPTH_TEST);
+        glDrawArrays(GL_LINES, firstOverlay, numOverlayVertices);
+        if (depthTest) {
+            glEnable(GL_DEPTH_TEST);
+        }
+    }
+
+    if (numPointVertices > 0) {
+        glPointSize(m_pointSize);
+        glDrawArrays(GL_POINTS, firstPoint, numPointVertices);
+    }
+
+    if (numTriangleVertices > 0) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        glDrawArrays(GL_TRIANGLES, firstTriangle, numTriangleVertices);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % NUM_REGIONS;
+
+    clearQueues();
+}
+
+void DebugDraw::clearQueues()
+{
+    m_lines.clear();
+    m_overlayLines.clear();
+    m_points.clear();
+    m_triangles.clear();
+    m_numQueued = 0;
+}
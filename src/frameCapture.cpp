@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "stb_image_write.h"
+
+#include "frameCapture.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+
+FrameCapture::~FrameCapture()
+{
+    stop();
+
+    for (Slot& slot : m_slots) {
+        if (slot.PBO != 0) {
+            glDeleteBuffers(1, &slot.PBO);
+        }
+    }
+}
+
+bool FrameCapture::start(const std::string& path, int width, int height, int fps)
+{
+    if (m_active) {
+        return true;
+    }
+
+    std::string extension = std::filesystem::path(path).extension().string();
+    m_format = extension == ".y4m" ? FORMAT_Y4M : FORMAT_PNG;
+    m_path = path;
+
+    if (m_format == FORMAT_Y4M) {
+        m_pY4mFile = fopen(path.c_str(), "wb");
+        if (m_pY4mFile == nullptr) {
+            printf(RED_TEXT "Capture: cannot open '%s'" RESET_TEXT "\n", path.c_str());
+            return false;
+        }
+
+        // Full-range BT.601 ("jpeg") chroma, the same matrix writeY4m() converts with
+        fprintf(m_pY4mFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    } else {
+        std::error_code error;
+        std::filesystem::create_directories(path, error);
+        if (error) {
+            printf(RED_TEXT "Capture: cannot create '%s': %s" RESET_TEXT "\n", path.c_str(), error.message().c_str());
+            return false;
+        }
+    }
+
+    size_t frameBytes = static_cast<size_t>(width) * height * 4;
+
+    // The slots only need reallocating when the frame size changed since the last recording
+    if (frameBytes != m_frameBytes) {
+        for (Slot& slot : m_slots) {
+            if (slot.PBO != 0) {
+                glDeleteBuffers(1, &slot.PBO);
+            }
+
+            glCreateBuffers(1, &slot.PBO);
+            glNamedBufferStorage(slot.PBO, frameBytes, nullptr, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT);
+        }
+
+        std::lock_guard<std::mutex> lock(m_bufferMutex);
+        m_freeBuffers.clear();
+    }
+
+    m_width = width;
+    m_height = height;
+    m_frameBytes = frameBytes;
+
+    // Order matters for a stream, so Y4M gets one writer; PNG frames are independent files
+    m_pEncoders = std::make_unique<ThreadPool>(m_format == FORMAT_Y4M ? 1 : 0);
+
+    // Throughput matters more than file size while recording
+    stbi_write_png_compression_level = 1;
+    stbi_flip_vertically_on_write(1);
+
+    m_numCaptured = 0;
+    m_numDropped = 0;
+    m_numWriteErrors = 0;
+    m_sizeMismatchReported = false;
+    m_nextSlot = 0;
+    m_startTime = std::chrono::steady_clock::now();
+    m_active = true;
+
+    printf("Capture: recording %dx%d %s to '%s'\n", width, height, m_format == FORMAT_Y4M ? "Y4M" : "PNG", path.c_str());
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void FrameCapture::stop()
+{
+    if (!m_active) {
+        return;
+    }
+
+    // Drain the ring oldest first so a stream keeps its frame order
+    for (uint32_t i = 0; i < NUM_SLOTS; i++) {
+        Slot& slot = m_slots[(m_nextSlot + i) % NUM_SLOTS];
+        if (slot.Fence) {
+            glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            collect(slot);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+
+    m_pEncoders->wait();
+    m_pEncoders.reset();
+
+    if (m_pY4mFile) {
+        fclose(m_pY4mFile);
+        m_pY4mFile = nullptr;
+    }
+
+    m_active = false;
+
+    printf("Capture: %lu frames in %.2f s (%.1f fps sustained), %lu dropped, to '%s'\n",
+           (unsigned long)m_numCaptured, seconds, seconds > 0.0 ? m_numCaptured / seconds : 0.0, (unsigned long)m_numDropped, m_path.c_str());
+
+    if (m_numWriteErrors > 0) {
+        printf(RED_TEXT "Capture: %lu frames failed to write" RESET_TEXT "\n", (unsigned long)m_numWriteErrors.load());
+    }
+}
+
+double FrameCapture::getCaptureFps() const
+{
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+
+    return seconds > 0.0 ? m_numCaptured / seconds : 0.0;
+}
+
+void FrameCapture::captureFrame(int width, int height)
+{
+    if (!m_active) {
+        return;
+    }
+
+    TRACE_SCOPE("FrameCapture::captureFrame");
+
+    // A resized window no longer fits the slots or the stream header
+    if (width != m_width || height != m_height) {
+        if (!m_sizeMismatchReported) {
+            printf(RED_TEXT "Capture: framebuffer is %dx%d, recording %dx%d; frames are dropped until it matches" RESET_TEXT "\n",
+                   width, height, m_width, m_height);
+            m_sizeMismatchReported = true;
+        }
+        m_numDropped++;
+        return;
+    }
+
+    // Hand over every frame the GPU has finished, oldest first. Fences signal in submission
+    // order, so the first pending one ends the scan.
+    for (uint32_t i = 0; i < NUM_SLOTS; i++) {
+        Slot& slot = m_slots[(m_nextSlot + i) % NUM_SLOTS];
+        if (!slot.Fence) {
+            continue;
+        }
+
+        GLenum status = glClientWaitSync(slot.Fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+
+        collect(slot);
+    }
+
+    Slot& slot = m_slots[m_nextSlot];
+
+    // Still in flight after NUM_SLOTS frames: the GPU is behind, waiting here would stall the frame
+    if (slot.Fence) {
+        m_numDropped++;
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_nextSlot = (m_nextSlot + 1) % NUM_SLOTS;
+}
+
+void FrameCapture::collect(Slot& slot)
+{
+    glDeleteSync(slot.Fence);
+    slot.Fence = nullptr;
+
+    if (m_pEncoders->getPendingJobs() >= MAX_PENDING_ENCODES) {
+        m_numDropped++;
+        return;
+    }
+
+    const void* pMapped = glMapNamedBufferRange(slot.PBO, 0, m_frameBytes, GL_MAP_READ_BIT);
+    if (pMapped == nullptr) {
+        m_numDropped++;
+        return;
+    }
+
+    std::vector<unsigned char> pixels = acquireBuffer();
+    memcpy(pixels.data(), pMapped, m_frameBytes);
+    glUnmapNamedBuffer(slot.PBO);
+
+    uint64_t frameIndex = m_numCaptured++;
+
+    m_pEncoders->submit([this, frameIndex, pixels = std::move(pixels)]() mutable {
+        if (m_format == FORMAT_Y4M) {
+            writeY4m(pixels);
+        } else {
+            encodePng(pixels, frameIndex);
+        }
+
+        releaseBuffer(std::move(pixels));
+    });
+}
+
+void FrameCapture::encodePng(std::vector<unsigned char>& pixels, uint64_t frameIndex)
+{
+    TRACE_SCOPE("FrameCapture::encodePng");
+
+    // Blended passes leave destination alpha below one, the recording should be opaque
+    for (size_t i = 3; i < pixels.size(); i += 4) {
+        pixels[i] = 255;
+    }
+
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "frame_%06lu.png", (unsigned long)frameIndex);
+    std::string path = (std::filesystem::path(m_path) / fileName).string();
+
+    if (!stbi_write_png(path.c_str(), m_width, m_height, 4, pixels.data(), m_width * 4)) {
+        m_numWriteErrors++;
+    }
+}
+
+void FrameCapture::writeY4m(const std::vector<unsigned char>& pixels)
+{
+    TRACE_SCOPE("FrameCapture::writeY4m");
+
+    int chromaWidth = (m_width + 1) / 2;
+    int chromaHeight = (m_height + 1) / 2;
+    size_t lumaBytes = static_cast<size_t>(m_width) * m_height;
+    size_t chromaBytes = static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    m_yuv.resize(lumaBytes + 2 * chromaBytes);
+    unsigned char* pY = m_yuv.data();
+    unsigned char* pU = pY + lumaBytes;
+    unsigned char* pV = pU + chromaBytes;
+
+    // GL rows start at the bottom, Y4M rows at the top
+    auto pixel = [&](int x, int y) {
+        return &pixels[(static_cast<size_t>(m_height - 1 - y) * m_width + x) * 4];
+    };
+
+    for (int y = 0; y < m_height; y++) {
+        for (int x = 0; x < m_width; x++) {
+            const unsigned char* p = pixel(x, y);
+            pY[static_cast<size_t>(y) * m_width + x] = static_cast<unsigned char>((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+        }
+    }
+
+    // Each chroma sample averages a 2x2 block, clamped at odd edges
+    for (int cy = 0; cy < chromaHeight; cy++) {
+        for (int cx = 0; cx < chromaWidth; cx++) {
+            int r = 0, g = 0, b = 0;
+
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    const unsigned char* p = pixel(std::min(2 * cx + dx, m_width - 1), std::min(2 * cy + dy, m_height - 1));
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                }
+            }
+
+            // Sums of four samples, hence the extra 2 bits of shift; the offset keeps the terms positive
+            size_t index = static_cast<size_t>(cy) * chromaWidth + cx;
+            pU[index] = static_cast<unsigned char>(std::min(255, (-43 * r - 85 * g + 128 * b + (128 << 10) + 512) >> 10));
+            pV[index] = static_cast<unsigned char>(std::min(255, (128 * r - 107 * g - 21 * b + (128 << 10) + 512) >> 10));
+        }
+    }
+
+    bool written = fputs("FRAME\n", m_pY4mFile) >= 0;
+    written = written && fwrite(m_yuv.data(), 1, m_yuv.size(), m_pY4mFile) == m_yuv.size();
+
+    if (!written) {
+        m_numWriteErrors++;
+    }
+}
+
+std::vector<unsigned char> FrameCapture::acquireBuffer()
+{
+    std::lock_guard<std::mutex> lock(m_bufferMutex);
+
+    if (m_freeBuffers.empty()) {
+        return std::vector<unsigned char>(m_frameBytes);
+    }
+
+    std::vector<unsigned char> buffer = std::move(m_freeBuffers.back());
+    m_freeBuffers.pop_back();
+
+    return buffer;
+}
+
+void FrameCapture::releaseBuffer(std::vector<unsigned char>&& buffer)
+{
+    std::lock_guard<std::mutex> lock(m_bufferMutex);
+
+    if (buffer.size() == m_frameBytes) {
+        m_freeBuffers.push_back(std::move(buffer));
+    }
+}
@@ -0,0 +1,25 @@
+#include "frameUniforms.hpp"
+
+FrameUniforms::~FrameUniforms()
+{
+    if (m_UBO != 0) {
+        glDeleteBuffers(1, &m_UBO);
+    }
+}
+
+bool FrameUniforms::init()
+{
+    glCreateBuffers(1, &m_UBO);
+    glNamedBufferStorage(m_UBO, sizeof(FrameData), &m_data, GL_DYNAMIC_STORAGE_BIT);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, m_UBO);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void FrameUniforms::update(const FrameData& data)
+{
+    m_data = data;
+
+    glNamedBufferSubData(m_UBO, 0, sizeof(FrameData), &m_data);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, m_UBO);
+}
@@ -1,303 +1,133 @@
 
 #include "gizmo.hpp"
 
-const char* Gizmo::vertexShaderSource = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 2) in vec3 aNormal;
-
-out vec3 FragPos;
-out vec3 Normal;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
-)";
-
-const char* Gizmo::fragmentShaderSource = R"(
-#version 330 core
-
-in vec3 FragPos;  // Position of the fragment
-in vec3 Normal;   // Normal at the fragment
-
-out vec4 FragColor;
-
-uniform vec3 lightPos;    // Position of the light
-uniform vec3 lightColor;  // Color of the light
-uniform vec3 objectColor; // Color of the object
-uniform vec3 viewPos;     // Position of the viewer/camera
-
-// Attenuation factors
-uniform float constant;
-uniform float linear;
-uniform float quadratic;
-
-void main()
-{
-    // Normalize the normal vector
-    vec3 norm = normalize(Normal);
-
-    // Calculate light direction
-    vec3 lightDir = normalize(lightPos - FragPos);
-
-    // Calculate view direction
-    vec3 viewDir = normalize(viewPos - FragPos);
-
-    // Diffuse lighting
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
-
-    // Specular lighting
-    vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32); // Shininess factor
-    vec3 specular = spec * lightColor;
-
-    // Ambient lighting
-    vec3 ambient = 1 * vec3(1.0, 1.0, 1.0); // Adjust the ambient intensity
-
-    // Calculate attenuation
-    float distance = length(lightPos - FragPos);
-    float attenuation = 1.0 / (constant + linear * distance + quadratic * (distance * distance));
-
-    // Combine all lighting components with attenuation
-    vec3 result = (ambient + diffuse + specular) * objectColor * attenuation;
-
-    FragColor = vec4(result, 1.0);
-}
-)";
-
-const char* Gizmo::wireframeShaderSource = R"(
-#version 330 core
-uniform vec3 wireframeColor; // Add this uniform
-out vec4 FragColor;
-
-void main() {
-    FragColor = vec4(wireframeColor, 1.0); // Use wireframe color
-}
-)";
-
-const char* Gizmo::lineFragmentShader = R"(
-#version 330 core
-out vec4 FragColor;
-
-uniform vec3 lineColor;
-
-void main() {
-    FragColor = vec4(lineColor, 1.0);
-}
-)";
-
-const char* Gizmo::lineShaderSource = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-
-uniform mat4 mvp; // Model-View-Projection matrix
-
-void main() {
-    gl_Position = mvp * vec4(aPos, 1.0);
-}
-)";
-
 Gizmo::Gizmo()
 {
-    int interval = 10;
-    std::thread t(&Gizmo::cbTimer, this, interval);
-    t.detach();
 }
 
 Gizmo::~Gizmo()
 {
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    Grid::shutdown();
+
+    if (pWindow) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     delete pMesh;
     delete pCamera;
 }
 
-GLuint Gizmo::compileShader(GLenum type, const char* source)
-{
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
-
-    // Check for compilation errors
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-    return shader;
+void Gizmo::drawLightLine(const glm::vec3& lightPos, const glm::vec3& lightTarget) {
+    // Drawn over the model like the original light line, which disabled depth testing
+    m_debugDraw.addLine(lightPos, lightTarget, glm::vec3(1.0f, 1.0f, 0.0f), false); // Yellow line
 }
 
-GLuint Gizmo::createShaderProgram()
+int Gizmo::init()
 {
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // Check for linking errors
-    GLint success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return -1;
     }
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
-}
-
-GLuint Gizmo::createWireframeShaderProgram() {
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource); // Use existing vertex shader
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, wireframeShaderSource); // Use wireframe fragment shader
-
-    GLuint wireframeProgram = glCreateProgram();
-    glAttachShader(wireframeProgram, vertexShader);
-    glAttachShader(wireframeProgram, fragmentShader);
-    glLinkProgram(wireframeProgram);
+    // 4.5 for the direct state access calls in Mesh and multi-draw-indirect with storage buffers
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SAMPLES, 16);     
 
-    // Check for linking errors
-    GLint success;
-    glGetProgramiv(wireframeProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(wireframeProgram, 512, nullptr, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    pWindow = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "HRT 2024", nullptr, nullptr);
+    if (pWindow == nullptr) {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
     }
+    glfwSetWindowUserPointer(pWindow, this);
+    glfwMakeContextCurrent(pWindow);
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return wireframeProgram;
-}
-
-GLuint Gizmo::createSimpleShaderProgram() {
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, lineShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, lineFragmentShader);
-
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    setCallbacks(pWindow);
 
-    // Check for linking errors
-    GLint success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    if (initRenderer() != 0) {
+        return -1;
     }
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
-}
-
-void Gizmo::drawLightLine(const glm::vec3& lightPos, const glm::vec3& lightTarget, const glm::mat4& mvp, GLuint shaderProgram) {
-    // Define the line vertices (start and end points)
-    glDisable(GL_DEPTH_TEST);
-    glm::vec3 lineVertices[] = { lightPos, lightTarget };
-
-    // Create VAO and VBO
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    // Bind and buffer data
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(lineVertices), lineVertices, GL_STATIC_DRAW);
+    pCamera->setWindow(pWindow);
 
-    // Configure vertex attributes
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glEnableVertexAttribArray(0);
+    // Initialize ImGui
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    ImGui_ImplGlfw_InitForOpenGL(pWindow, true);
+    ImGui_ImplOpenGL3_Init("#version 330");
 
-    // Use the shader program
-    glUseProgram(shaderProgram);
+    return 0;
+}
 
-    // Pass uniforms
-    GLuint mvpLoc = glGetUniformLocation(shaderProgram, "mvp");
-    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
+int Gizmo::initHeadless(int width, int height)
+{
+    m_pHeadlessContext = std::make_unique<HeadlessContext>();
+    if (!m_pHeadlessContext->init(4, 5)) {
+        std::cerr << "Failed to create a headless OpenGL context" << std::endl;
+        return -1;
+    }
 
-    GLuint colorLoc = glGetUniformLocation(shaderProgram, "lineColor");
-    glUniform3f(colorLoc, 1.0f, 1.0f, 0.0f); // Yellow line
+    if (initRenderer() != 0) {
+        return -1;
+    }
 
-    // Draw the line
-    glDrawArrays(GL_LINES, 0, 2);
+    // Same sample count as the window's GLFW_SAMPLES hint, clamped to what the device supports
+    if (!m_offscreenTarget.init(width, height, 16)) {
+        std::cerr << "Failed to initialize the offscreen framebuffer" << std::endl;
+        return -1;
+    }
 
-    // Cleanup
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    glDeleteBuffers(1, &VBO);
-    glDeleteVertexArrays(1, &VAO);
+    printf("Headless target: %dx%d, %d samples\n", width, height, m_offscreenTarget.getSamples());
 
-    glUseProgram(0); // Reset shader program
-    glEnable(GL_DEPTH_TEST);
+    return 0;
 }
 
-int Gizmo::init()
+// GL state shared by the windowed and the headless path, needs a current context
+int Gizmo::initRenderer()
 {
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
+    glewExperimental = GL_TRUE;
+    GLenum glewResult = glewInit();
+
+    // A GLX build of GLEW loads the core entry points first and only then fails to find an X display
+    bool headlessGlx = m_pHeadlessContext && glewResult == GLEW_ERROR_NO_GLX_DISPLAY;
+    if (glewResult != GLEW_OK && !headlessGlx) {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
         return -1;
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 16);     
+    // The programs issued from here on compile on driver threads; the lighting ones are only
+    // issued in loadModel(), once the vertex format is known and the import has started
+    if (Technique::EnableParallelCompile()) {
+        printf("Shader compilation: parallel, link status queried on first use\n");
+    }
 
-    pWindow = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "HRT 2024", nullptr, nullptr);
-    if (pWindow == nullptr) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+    if (!m_debugDraw.init()) {
+        std::cerr << "Failed to initialize debug drawing" << std::endl;
         return -1;
     }
-    glfwSetWindowUserPointer(pWindow, this);
-    glfwMakeContextCurrent(pWindow);
 
-    setCallbacks(pWindow);
+    if (!m_profiler.init()) {
+        std::cerr << "Failed to initialize the profiler" << std::endl;
+        return -1;
+    }
 
-    glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
+    if (!m_frameUniforms.init()) {
+        std::cerr << "Failed to initialize the frame uniform buffer" << std::endl;
         return -1;
     }
 
-    m_shaderProgram = createShaderProgram();
-    m_wireframeProgram = createWireframeShaderProgram();
-    m_lightProgram = createSimpleShaderProgram();
+    if (!Grid::init()) {
+        std::cerr << "Failed to initialize the grid" << std::endl;
+        return -1;
+    }
 
     pCamera = new Camera(glm::vec3(0.0f, 0.0f, 0.68f), glm::vec3(0.0f, 0.125f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    pCamera->setWindow(pWindow);
 
-    // Initialize ImGui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    ImGui_ImplGlfw_InitForOpenGL(pWindow, true);
-    ImGui_ImplOpenGL3_Init("#version 330");
-    
     glEnable(GL_MULTISAMPLE);
     glHint(GL_MULTISAMPLE_FILTER_HINT_NV, GL_NICEST);
     glEnable(GL_DEPTH_TEST);
@@ -307,10 +137,36 @@ int Gizmo::init()
     return 0;
 }
 
-bool Gizmo::loadModel(const std::string& filePath)
+bool Gizmo::loadModel(const std::string& filePath, const Mesh::LoadOptions& options)
 {
+    m_loadStart = std::chrono::steady_clock::now();
     pMesh = new Mesh();
-    if (pMesh->loadMesh(filePath))
+
+    // The import runs on the loader thread from here on, both in async and in blocking mode
+    Mesh::LoadOptions importOptions = options;
+    importOptions.Async = true;
+    if (!pMesh->loadMesh(filePath, importOptions)) {
+        std::cout << "\033[31m" << "Failed to start loading mesh: " << filePath << "\033[0m" << std::endl;
+        return false;
+    }
+
+    // Packed vertices need the dequantizing vertex shader. The programs compile while the
+    // importer works and are only waited for once nothing else is left to do.
+    if (!initLightingTechniques(options.VertexFormat == Mesh::VERTEX_FORMAT_QUANTIZED) || !completeLightingTechniques()) {
+        std::cerr << "Failed to initialize the lighting technique" << std::endl;
+        return false;
+    }
+
+    // In async mode the window keeps rendering while the model streams in, see reportLoadTimings()
+    if (options.Async) {
+        return true;
+    }
+
+    while (pMesh->update()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (pMesh->getLoadState() != Mesh::LOAD_DONE)
     {
         std::string title = "Failed to load mesh: " + filePath;
         std::cout << "\033[31m" << title << "\033[0m" << std::endl;
@@ -320,6 +176,57 @@ bool Gizmo::loadModel(const std::string& filePath)
     return true;
 }
 
+// Issues the direct and, when the context supports it, the indirect variant of the mesh shader.
+// completeLightingTechniques() collects the link results.
+bool Gizmo::initLightingTechniques(bool quantized)
+{
+    m_pLightingTechnique = std::make_unique<LightingTechnique>(quantized);
+    m_pLightingTechnique->SetDeferredCompletion(true);
+    if (!m_pLightingTechnique->Init()) {
+        return false;
+    }
+
+    m_pIndirectLightingTechnique.reset();
+
+    if (GLEW_VERSION_4_3) {
+        m_pIndirectLightingTechnique = std::make_unique<LightingTechnique>(quantized, true);
+        m_pIndirectLightingTechnique->SetDeferredCompletion(true);
+        if (!m_pIndirectLightingTechnique->Init()) {
+            std::cout << "\033[31m" << "Indirect lighting technique failed, multi-draw-indirect disabled" << "\033[0m" << std::endl;
+            m_pIndirectLightingTechnique.reset();
+        }
+    }
+
+    return true;
+}
+
+// Waits for the lighting programs, which blocks only on what the driver has not linked yet
+bool Gizmo::completeLightingTechniques()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if (!m_pLightingTechnique->Complete()) {
+        return false;
+    }
+
+    if (m_pIndirectLightingTechnique && !m_pIndirectLightingTechnique->Complete()) {
+        std::cout << "\033[31m" << "Indirect lighting technique failed, multi-draw-indirect disabled" << "\033[0m" << std::endl;
+        m_pIndirectLightingTechnique.reset();
+    }
+
+    if (!m_pIndirectLightingTechnique) {
+        m_indirectDraw = false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    printf("Lighting programs linked %.2f ms after launch, %.2f ms waiting on the driver, import %s\n",
+           std::chrono::duration<double, std::milli>(now - m_launchTime).count(),
+           std::chrono::duration<double, std::milli>(now - start).count(),
+           pMesh->getLoadState() == Mesh::LOAD_IN_PROGRESS ? "still running" : "already finished");
+
+    return true;
+}
+
 void Gizmo::setCallbacks(GLFWwindow* window)
 {
     glfwSetErrorCallback([](int error, const char* description) {
@@ -350,6 +257,17 @@ void Gizmo::setCallbacks(GLFWwindow* window)
         Gizmo* gizmo = static_cast<Gizmo*>(glfwGetWindowUserPointer(window));
         gizmo->cbScroll(window, xoffset, yoffset);
     });
+
+    // Camera drags are polled in Camera::update, the button events only have to wake the loop
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* window, int /*button*/, int /*action*/, int /*mods*/) {
+        Gizmo* gizmo = static_cast<Gizmo*>(glfwGetWindowUserPointer(window));
+        gizmo->requestRedraw();
+    });
+
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* window) {
+        Gizmo* gizmo = static_cast<Gizmo*>(glfwGetWindowUserPointer(window));
+        gizmo->requestRedraw();
+    });
 }
 
 void Gizmo::updateProjectionMatrix(int width, int height) {
@@ -358,55 +276,50 @@ void Gizmo::updateProjectionMatrix(int width, int height) {
     projection = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f);
 }
 
-void Gizmo::updateLightning(const GLuint shaderProgram)
+// Gathers the camera and light state into FrameData and uploads it once, before any draw of the frame
+void Gizmo::updateFrameData()
+{
+    FrameData frameData;
+    frameData.View = view;
+    frameData.Projection = projection;
+    frameData.ViewProjection = projection * view;
+    frameData.ViewPos = glm::vec4(pCamera->getPosition(), 1.0f);
+
+    updateLightning(frameData);
+
+    m_frameUniforms.update(frameData);
+}
+
+void Gizmo::updateLightning(FrameData& frameData)
 {
-    static float lightAngle = 0.0f; // Initial angle for light rotation
     static const float lightRadius = 5.0f; // Distance from the origin
-    static const float rotationSpeed = 0.075f; // Speed of rotation (radians per frame)
 
-    // Calculate light position
+    // Calculate light position from the angle blended between the last two simulation steps
+        float lightAngle = glm::mix(m_previousState.LightAngle, m_currentState.LightAngle, m_clock.getAlpha());
         float lightX = lightRadius * cos(lightAngle);
         float lightY = lightRadius * sin(lightAngle);
         glm::vec3 lightPos = glm::vec3(lightX, 1.0f, lightY); // Z-axis rotation
 
-        // Update light angle
-        if (tick)
-        {
-            lightAngle += rotationSpeed;
-            tick = false;
-        }
-
-        if (lightAngle > 2.0f * glm::pi<float>()) {
-            lightAngle -= 2.0f * glm::pi<float>();
-        }
-
-        glUseProgram(shaderProgram);
-        GLuint colorLoc = glGetUniformLocation(shaderProgram, "wireframeColor");
-        glUniform3f(colorLoc, 1.0f, 0.0f, 0.0f); // Set to red
-
         // Set light properties
         glm::vec3 lightColor = glm::vec3(1.0f, 1.0f, 0.9f);
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightColor"), 1, glm::value_ptr(lightColor));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(lightPos)); // Fixed
-
-        // Set viewer position
-        glm::vec3 viewPos = pCamera->getPosition();
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(viewPos));
+        frameData.LightPos = glm::vec4(lightPos, 1.0f);
+        frameData.LightColor = glm::vec4(lightColor, 1.0f);
 
         // Set attenuation factors
-        glUniform1f(glGetUniformLocation(shaderProgram, "constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "linear"), 0.09f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "quadratic"), 0.032f);
+        frameData.Attenuation = glm::vec4(1.0f, 0.09f, 0.032f, 0.0f);
 }
 
 void Gizmo::cbFramebufferSize(GLFWwindow* /*window*/, int width, int height)
 {
     glViewport(0, 0, width, height);
     updateProjectionMatrix(width, height);
+    requestRedraw();
 }
 
 void Gizmo::cbKeyboard(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/)
 {
+    requestRedraw();
+
     if (action == GLFW_PRESS)
     {
         if (key == GLFW_KEY_ESCAPE) {
@@ -416,29 +329,126 @@ void Gizmo::cbKeyboard(GLFWwindow* window, int key, int /*scancode*/, int action
             std::string title = "Shutdown aborted";
             std::cout << "\033[35m" << title << "\033[0m" << std::endl;
             runIndifinitely = true;
+        }
+        else if (key == GLFW_KEY_I) {
+            if (!m_pIndirectLightingTechnique) {
+                std::cout << "\033[35m" << "Multi-draw-indirect needs OpenGL 4.3" << "\033[0m" << std::endl;
+                return;
+            }
+
+            reportSubmitTimings();
+            m_indirectDraw = !m_indirectDraw;
+            printf("Submission mode: %s\n", m_indirectDraw ? "multi-draw-indirect" : "direct");
+        }
+        else if (key == GLFW_KEY_C) {
+            if (m_frameCapture.isActive()) {
+                m_frameCapture.stop();
+            } else {
+                startCapture(m_capturePath);
+            }
+        }
+        else if (key == GLFW_KEY_O) {
+            m_renderOnDemand = !m_renderOnDemand;
+            printf("Render on demand: %s\n", m_renderOnDemand ? "on" : "off");
+        }
+        else if (key == GLFW_KEY_P) {
+            m_clock.setPaused(!m_clock.isPaused());
+        }
+        else if (key == GLFW_KEY_T) {
+#ifdef GFX_ENABLE_TRACING
+            TRACE_DUMP("trace.json");
+#else
+            std::cout << "\033[35m" << "Tracing is compiled out, rebuild with GFX_TRACE=1 ./run.sh" << "\033[0m" << std::endl;
+#endif
         }        
     }
 }
 
 void Gizmo::cbMouseMotion(GLFWwindow* /*window*/, double xpos, double ypos)
 {
+    requestRedraw();
 }
 
 void Gizmo::cbScroll(GLFWwindow* window, double xoffset, double yoffset)
 {
     pCamera->scrollCallback(window, xoffset, yoffset);
+    requestRedraw();
+}
+
+// Advances the animated state by one fixed step of dt simulated seconds
+void Gizmo::stepSimulation(float dt)
+{
+    static const float lightSpeed = 1.5f; // radians per second
+    static const float meshSpeed = 3.0f;  // degrees per second
+
+    m_previousState = m_currentState;
+    m_currentState.LightAngle += lightSpeed * dt;
+    m_currentState.MeshAngle += meshSpeed * dt;
+
+    // Wrap both states together so the blend between them never crosses the seam
+    if (m_currentState.LightAngle > 2.0f * glm::pi<float>()) {
+        m_currentState.LightAngle -= 2.0f * glm::pi<float>();
+        m_previousState.LightAngle -= 2.0f * glm::pi<float>();
+    }
+
+    if (m_currentState.MeshAngle > 360.0f) {
+        m_currentState.MeshAngle -= 360.0f;
+        m_previousState.MeshAngle -= 360.0f;
+    }
 }
 
-void Gizmo::cbTimer(int interval)
+// Counts a timed run down once per second; true when its time is up, never after Space was pressed
+bool Gizmo::shutdownDue()
 {
-    int count = 0;
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(interval));
-        count++;
-        if (count % 5 == 0) { tick = true; }
-        if (count % 25 == 0) { toggle = !toggle; }
-        if (count % 100 == 0) { count = 0; }
+    if (!m_timedRun || runIndifinitely) {
+        return false;
     }
+
+    auto remaining = std::chrono::ceil<std::chrono::seconds>(m_shutdownTime - std::chrono::steady_clock::now()).count();
+
+    if (remaining > 0 && remaining != m_shutdownCountdown) {
+        std::string title = "Shutting down in " + std::to_string(remaining) + " seconds ...";
+        std::cout << "\033[33m" << title << "\033[0m" << std::endl;
+        m_shutdownCountdown = remaining;
+    }
+
+    return remaining <= 0;
+}
+
+// True when something visible may differ from the last drawn frame
+bool Gizmo::needsRedraw(const glm::mat4& newView) const
+{
+    bool animating = !m_clock.isPaused() && m_clock.getTimeScale() > 0.0f;
+    bool loading = pMesh->getLoadState() == Mesh::LOAD_IN_PROGRESS;
+
+    return m_redrawFrames > 0 || animating || loading || !m_firstFrameReported || newView != view;
+}
+
+// Blocks until an event arrives or the idle timeout expires, and accounts the time as skipped
+void Gizmo::waitForEvents()
+{
+    auto start = std::chrono::steady_clock::now();
+    glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+    m_idleSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_framesSkipped++;
+
+    // Keep the frame clock current so the idle gap is not simulated once animation resumes
+    m_clock.advance();
+}
+
+// Steps the simulation as far as the clock says is due and hands the blended state to the mesh
+void Gizmo::updateSimulation()
+{
+    int numSteps = m_pHeadlessContext ? m_clock.advanceBy(HEADLESS_FRAME_SECONDS) : m_clock.advance();
+
+    for (int i = 0; i < numSteps; i++) {
+        stepSimulation(static_cast<float>(m_clock.getFixedStep()));
+    }
+
+    // The lamp flashes every quarter of a simulated second
+    m_lampHighlight = fmod(m_clock.getSimulationTime(), 0.5) >= 0.25;
+
+    pMesh->setAnimationAngle(glm::mix(m_previousState.MeshAngle, m_currentState.MeshAngle, m_clock.getAlpha()));
 }
 
 void Gizmo::handleSnapToBorders(GLFWwindow* pWindow) {
@@ -483,42 +493,345 @@ void Gizmo::gui(GLFWwindow* window)
     ImGui::Begin("Draggable Window");
     handleSnapToBorders(window);
     ImGui::Text("Hello from the side panel!");  // Add a label
+
+    if (pMesh->getLoadState() == Mesh::LOAD_IN_PROGRESS) {
+        ImGui::Text("Loading model...");
+        ImGui::ProgressBar(pMesh->getLoadProgress(), ImVec2(-1.0f, 0.0f));
+    }
+
+    m_profiler.drawGui();
+
+    bool paused = m_clock.isPaused();
+    if (ImGui::Checkbox("Pause simulation (P)", &paused)) {
+        m_clock.setPaused(paused);
+    }
+    float timeScale = m_clock.getTimeScale();
+    if (ImGui::SliderFloat("Time scale", &timeScale, 0.0f, 4.0f)) {
+        m_clock.setTimeScale(timeScale);
+    }
+    ImGui::Text("Simulation time %.2f s", m_clock.getSimulationTime());
+
+    if (m_frameCapture.isActive()) {
+        ImGui::Text("Capture: %lu frames, %lu dropped, %.1f fps (C to stop)",
+                    (unsigned long)m_frameCapture.getNumCaptured(), (unsigned long)m_frameCapture.getNumDropped(), m_frameCapture.getCaptureFps());
+    }
+
+    ImGui::Checkbox("Render on demand (O)", &m_renderOnDemand);
+    ImGui::Text("Frames drawn %lu, skipped %lu, idle %.1f s", (unsigned long)m_framesRendered, (unsigned long)m_framesSkipped, m_idleSeconds);
+
+    ImGui::Text("Submission: %s (I to toggle)", m_indirectDraw ? "multi-draw-indirect" : "direct");
+    const SubmitTiming& timing = m_submitTimings[m_indirectDraw ? 1 : 0];
+    if (timing.Frames > 0) {
+        ImGui::Text("Submit CPU: %.3f ms", timing.TotalMs / timing.Frames);
+    }
+
+    bool frustumCulling = pMesh->getFrustumCulling();
+    if (ImGui::Checkbox("Frustum culling", &frustumCulling)) {
+        pMesh->setFrustumCulling(frustumCulling);
+    }
+    ImGui::Text("Meshes drawn %u, culled %u", pMesh->getNumDrawnMeshes(), pMesh->getNumCulledMeshes());
+    ImGui::Text("Transforms: %u updated in %.3f ms", pMesh->getNumTransformsUpdated(), pMesh->getTransformUpdateMs());
+
+    if (pMesh->hasLods()) {
+        float lodPixelError = pMesh->getLodPixelError();
+        if (ImGui::SliderFloat("LOD error (px)", &lodPixelError, 0.0f, 8.0f)) {
+            pMesh->setLodPixelError(lodPixelError);
+        }
+
+        const auto& counts = pMesh->getLodDrawCounts();
+        ImGui::Text("Draws per LOD:");
+        for (size_t level = 0; level < counts.size(); level++) {
+            ImGui::SameLine();
+            ImGui::Text("L%zu %u", level, counts[level]);
+        }
+    }
+
     ImGui::End();
 }
 
+void Gizmo::reportLoadTimings()
+{
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_loadStart).count();
+
+    if (!m_firstFrameReported) {
+        double launchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_launchTime).count();
+        printf("Time to first frame: %.2f ms\n", ms);
+        printf("Launch to first frame: %.2f ms\n", launchMs);
+        // Every program, including the deferred grid and line ones, has been completed by now
+        ProgramCache::instance().printStats();
+        m_firstFrameReported = true;
+    }
+
+    Mesh::LOAD_STATE state = pMesh->getLoadState();
+
+    if (!m_loadReported && state != Mesh::LOAD_IN_PROGRESS) {
+        if (state == Mesh::LOAD_FAILED) {
+            std::cout << "\033[31m" << "Failed to load mesh" << "\033[0m" << std::endl;
+        } else {
+            printf("Time to fully loaded model: %.2f ms\n", ms);
+        }
+        m_loadReported = true;
+    }
+}
+
+// Issues the model's draws in the selected submission mode and accumulates the CPU cost of the call
+void Gizmo::renderMesh()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if (m_indirectDraw && m_pIndirectLightingTechnique) {
+        pMesh->renderIndirect(*m_pIndirectLightingTechnique, view, projection, m_lampHighlight);
+    } else {
+        pMesh->render(*m_pLightingTechnique, view, projection, m_lampHighlight);
+    }
+
+    SubmitTiming& timing = m_submitTimings[m_indirectDraw ? 1 : 0];
+    timing.TotalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    timing.Frames++;
+}
+
+void Gizmo::reportSubmitTimings()
+{
+    const char* names[2] = { "direct", "multi-draw-indirect" };
+
+    for (int mode = 0; mode < 2; mode++) {
+        const SubmitTiming& timing = m_submitTimings[mode];
+        if (timing.Frames > 0) {
+            printf("Submit CPU (%s): %.3f ms/frame over %lu frames\n", names[mode], timing.TotalMs / timing.Frames, (unsigned long)timing.Frames);
+        }
+    }
+}
+
+// Draws the loaded model numFrames times with the normal matrix inverted per vertex in the
+// shader and with the CPU-side normal matrix, and prints both vertex throughputs side by side.
+void Gizmo::benchmarkNormalMatrix(int numFrames)
+{
+    while (pMesh->update()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    LightingTechnique shaderInverse(m_pLightingTechnique->IsQuantized(), false, true);
+    if (!shaderInverse.Init()) {
+        std::cout << "\033[31m" << "Failed to initialize the per-vertex inverse technique" << "\033[0m" << std::endl;
+        return;
+    }
+
+    struct Variant {
+        const char* Name;
+        LightingTechnique* pTechnique;
+    };
+
+    Variant variants[2] = {
+        { "per-vertex inverse", &shaderInverse },
+        { "CPU normal matrix", m_pLightingTechnique.get() }
+    };
+
+    int width, height;
+    glfwGetFramebufferSize(pWindow, &width, &height);
+    glViewport(0, 0, width, height);
+    updateProjectionMatrix(width, height);
+    view = pCamera->getViewMatrix();
+    updateFrameData();
+
+    printf("Normal matrix benchmark (%d frames)\n", numFrames);
+    printf("%20s %12s %12s %14s\n", "variant", "ms/frame", "indices", "Mverts/s");
+
+    for (const Variant& variant : variants) {
+        // Warm up so shader compilation and buffer residency stay out of the measurement
+        for (int i = 0; i < 5; i++) {
+            pMesh->render(*variant.pTechnique, view, projection, m_lampHighlight);
+        }
+        glFinish();
+
+        uint64_t numIndices = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < numFrames; i++) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // A fixed step per frame keeps the animated transforms updating every iteration
+            pMesh->setAnimationAngle(i * 0.05f);
+            pMesh->render(*variant.pTechnique, view, projection, m_lampHighlight);
+            numIndices += pMesh->getNumIndicesDrawn();
+        }
+        glFinish();
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printf("%20s %12.3f %12lu %14.2f\n", variant.Name, ms / numFrames, (unsigned long)(numIndices / numFrames),
+               numIndices / (ms * 1000.0));
+    }
+}
+
+// One frame into the bound framebuffer, shared by run() and renderHeadless(); the caller
+// sets the view and ends the profiler frame once the image is presented or read back
+void Gizmo::renderFrame(int width, int height)
+{
+    m_profiler.beginFrame();
+    updateSimulation();
+
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    updateProjectionMatrix(width, height);
+    updateFrameData();
+
+    {
+        Profiler::Scope scope(m_profiler, "Upload");
+        pMesh->update();
+    }
+
+    if (pWindow) {
+        TRACE_SCOPE("Gizmo::gui");
+        gui(pWindow);
+    }
+
+    {
+        Profiler::Scope scope(m_profiler, "Mesh");
+        renderMesh();
+    }
+
+    {
+        Profiler::Scope scope(m_profiler, "Grid");
+        Grid::renderGrid();
+    }
+
+    {
+        Profiler::Scope scope(m_profiler, "Debug draw");
+        m_debugDraw.flush();
+    }
+
+    if (pWindow) {
+        Profiler::Scope scope(m_profiler, "ImGui");
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
+}
+
+bool Gizmo::startCapture(const std::string& path)
+{
+    m_capturePath = path;
+
+    int width, height;
+    glfwGetFramebufferSize(pWindow, &width, &height);
+
+    return m_frameCapture.start(path, width, height, 60);
+}
+
+bool Gizmo::renderHeadless(const std::vector<OrbitPose>& poses, int numFrames, const std::string& outputDir)
+{
+    // Finish an async load first so every image shows the complete model
+    while (pMesh->update()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (pMesh->getLoadState() != Mesh::LOAD_DONE) {
+        std::cout << "\033[31m" << "Failed to load mesh, no images written" << "\033[0m" << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(outputDir, error);
+    if (error) {
+        std::cout << "\033[31m" << "Cannot create output directory '" << outputDir << "': " << error.message() << "\033[0m" << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < numFrames; frame++) {
+        TRACE_SCOPE("Gizmo::renderHeadless frame");
+
+        pCamera->setOrbit(poses.empty() ? OrbitPose() : poses[frame % poses.size()]);
+        view = pCamera->getViewMatrix();
+
+        m_offscreenTarget.bind();
+        renderFrame(m_offscreenTarget.getWidth(), m_offscreenTarget.getHeight());
+
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "frame_%04d.png", frame);
+        std::string path = (std::filesystem::path(outputDir) / fileName).string();
+
+        bool saved = m_offscreenTarget.savePng(path);
+        m_profiler.endFrame();
+        reportLoadTimings();
+
+        if (!saved) {
+            return false;
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Headless: wrote %d frames (%dx%d) to '%s' in %.2f ms\n", numFrames, m_offscreenTarget.getWidth(), m_offscreenTarget.getHeight(), outputDir.c_str(), ms);
+
+    TRACE_DUMP("trace.json");
+    return true;
+}
+
 void Gizmo::run(int runForSeconds)
 {
     if (runForSeconds > 0) {
-        utils::timer::shutdown(runForSeconds, &runIndifinitely);
+        m_shutdownTime = std::chrono::steady_clock::now() + std::chrono::seconds(runForSeconds);
+        m_timedRun = true;
     }
 
+    TRACE_THREAD_NAME("Main");
+
     while (!glfwWindowShouldClose(pWindow)) {
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // A timed run leaves through the end of this function like Esc does, so capture,
+        // trace and statistics are finished and printed
+        if (shutdownDue()) {
+            glfwSetWindowShouldClose(pWindow, GLFW_TRUE);
+            continue;
+        }
 
         pCamera->update();
-        view = pCamera->getViewMatrix();
-        
+        glm::mat4 newView = pCamera->getViewMatrix();
+
+        if (m_renderOnDemand && !needsRedraw(newView)) {
+            waitForEvents();
+            continue;
+        }
+
+        TRACE_SCOPE("Gizmo::run frame");
+        view = newView;
+
         int width, height;
         glfwGetFramebufferSize(pWindow, &width, &height);
-        updateProjectionMatrix(width, height);
-        updateLightning(m_shaderProgram);
-
+        renderFrame(width, height);
 
-        gui(pWindow);
-        pMesh->render(m_shaderProgram, view, projection, toggle);
-        auto matrices = Grid::GridMatrices(view, projection);
-        Grid::renderGrid(matrices, pCamera->getPosition());
+        if (m_frameCapture.isActive()) {
+            Profiler::Scope scope(m_profiler, "Capture");
+            m_frameCapture.captureFrame(width, height);
+        }
 
+        {
+            Profiler::Scope scope(m_profiler, "Swap");
+            TRACE_SCOPE("Swap");
+            glfwSwapBuffers(pWindow);
+        }
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(pWindow);
         glfwPollEvents();
+
+        reportLoadTimings();
+        m_profiler.endFrame();
+
+        m_framesRendered++;
+        if (m_redrawFrames > 0) {
+            m_redrawFrames--;
+        }
     }
+
+    m_frameCapture.stop();
+
+    if (m_framesSkipped > 0) {
+        printf("Render on demand: %lu frames drawn, %lu idle wakeups skipped, %.1f s idle\n",
+               (unsigned long)m_framesRendered, (unsigned long)m_framesSkipped, m_idleSeconds);
+    }
+
+    reportSubmitTimings();
+    TRACE_DUMP("trace.json");
 }
 
 
-        // pMesh->drawTriangles(m_wireframeProgram, mvp);
-        // drawLightLine(lightPos, lightTarget, mvp, m_lightProgram);
+        // pMesh->drawTriangles(m_debugDraw, model);
+        // drawLightLine(lightPos, lightTarget);
 
@@ -1,13 +1,11 @@
+#include "frameUniforms.hpp"
 #include "grid.hpp"
+#include "trace.hpp"
 
 namespace Grid
 {
-    const char* VertexShader = R"(
-    #version 330 core
-
-    uniform mat4 gVP;
+    const char* VertexShader = "#version 330 core\n" FRAME_DATA_GLSL R"(
     uniform float gGridSize;
-    uniform vec3 gCameraWorldPos;
 
     out vec3 WorldPos;
 
@@ -26,22 +24,19 @@ namespace Grid
         vec3 vPos3 = Pos[Index] * gGridSize;
 
         // Position the quad around the camera for testing
-        vPos3.x += gCameraWorldPos.x;
-        vPos3.z += gCameraWorldPos.z;
+        vPos3.x += gViewPos.x;
+        vPos3.z += gViewPos.z;
 
-        gl_Position = gVP * vec4(vPos3, 1.0);
+        gl_Position = gViewProjection * vec4(vPos3, 1.0);
         WorldPos = vPos3;
     }
     )";
 
-    const char* FragmentShader = R"(
-    #version 330 core
-
+    const char* FragmentShader = "#version 330 core\n" FRAME_DATA_GLSL R"(
     in vec3 WorldPos;
 
     layout(location = 0) out vec4 FragColor;
 
-    uniform vec3 gCameraWorldPos;
     uniform float gGridSize = 100.0;
     uniform float gGridMinPixelsBetweenCells = 2.0;
     uniform float gGridCellSize = 0.025;
@@ -118,7 +113,7 @@ namespace Grid
         }
 
         // Optional distance-based fadeout
-        float OpacityFalloff = (1.0 - satf(length(WorldPos.xz - gCameraWorldPos.xz) / gGridSize));
+        float OpacityFalloff = (1.0 - satf(length(WorldPos.xz - gViewPos.xz) / gGridSize));
         Color.a = lineAlpha * OpacityFalloff;
 
         FragColor = Color;
@@ -126,83 +121,76 @@ namespace Grid
     )";
 
     InfiniteGridConfig config;
-    GLuint m_gridProgram = -1;
+    GridTechnique* m_pGridTechnique = nullptr;
 
-    GLuint compileShader(GLenum type, const char* source)
+    GridTechnique::~GridTechnique()
     {
-        GLuint shader = glCreateShader(type);
-        glShaderSource(shader, 1, &source, nullptr);
-        glCompileShader(shader);
-
-        GLint success;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            char infoLog[512];
-            glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-            std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+        if (m_VAO != 0) {
+            glDeleteVertexArrays(1, &m_VAO);
         }
-
-        return shader;
     }
 
-    GLuint createGridProgram()
+    bool GridTechnique::Init()
     {
-        GLuint vertexShader = compileShader(GL_VERTEX_SHADER, VertexShader);
-        GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, FragmentShader);
-
-        GLuint m_gridProgram = glCreateProgram();
-        glAttachShader(m_gridProgram, vertexShader);
-        glAttachShader(m_gridProgram, fragmentShader);
-        glLinkProgram(m_gridProgram);
-
-        GLint success;
-        glGetProgramiv(m_gridProgram, GL_LINK_STATUS, &success);
-        if (!success) {
-            char infoLog[512];
-            glGetProgramInfoLog(m_gridProgram, 512, nullptr, infoLog);
-            std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        if (!Technique::Init()) {
+            return false;
         }
 
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
+        // Core profile needs a VAO bound even though the vertices come from gl_VertexID
+        glCreateVertexArrays(1, &m_VAO);
 
-        return m_gridProgram;
+        if (!AddShaderSource(GL_VERTEX_SHADER, VertexShader, "grid.vs")) {
+            return false;
+        }
+
+        if (!AddShaderSource(GL_FRAGMENT_SHADER, FragmentShader, "grid.fs")) {
+            return false;
+        }
+
+        return Finalize();
     }
 
-    void renderGrid(const GridMatrices gMats, const Vector3f& cameraPosition)
+    bool GridTechnique::OnLinked()
     {
-        GLuint VAO;
-        glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
-        
-        if (m_gridProgram == -1) {
-            m_gridProgram = createGridProgram();
-        }
-        
-        glUseProgram(m_gridProgram);
+        GET_UNIFORM_AND_CHECK(m_gridSizeLoc, "gGridSize");
+        GET_UNIFORM_AND_CHECK(m_gridCellSizeLoc, "gGridCellSize");
+        GET_UNIFORM_AND_CHECK(m_gridColorThinLoc, "gGridColorThin");
+        GET_UNIFORM_AND_CHECK(m_gridColorThickLoc, "gGridColorThick");
+        GET_UNIFORM_AND_CHECK(m_gridMinPixelsBetweenCellsLoc, "gGridMinPixelsBetweenCells");
 
-        glm::mat4 gVP = gMats.Projection * gMats.View;
-        GLint gVPUniform = glGetUniformLocation(m_gridProgram, "gVP");
-        glUniformMatrix4fv(gVPUniform, 1, GL_FALSE, glm::value_ptr(gVP));
+        return true;
+    }
 
-        // Set uniforms
-        GLint gridSizeUniform = glGetUniformLocation(m_gridProgram, "gGridSize");
-        glUniform1f(gridSizeUniform, config.Size);
+    bool GridTechnique::Enable()
+    {
+        if (!Technique::Enable()) {
+            return false;
+        }
 
-        GLint gridCellSizeUniform = glGetUniformLocation(m_gridProgram, "gGridCellSize");
-        glUniform1f(gridCellSizeUniform, config.CellSize);
+        glBindVertexArray(m_VAO);
+        return true;
+    }
 
-        GLint cameraPosUniform = glGetUniformLocation(m_gridProgram, "gCameraWorldPos");
-        glUniform3f(cameraPosUniform, cameraPosition.x, cameraPosition.y, cameraPosition.z);
+    void GridTechnique::SetConfig(const InfiniteGridConfig& config)
+    {
+        glUniform1f(m_gridSizeLoc, config.Size);
+        glUniform1f(m_gridCellSizeLoc, config.CellSize);
+        glUniform4f(m_gridColorThinLoc, config.ColorThin.x, config.ColorThin.y, config.ColorThin.z, config.ColorThin.w);
+        glUniform4f(m_gridColorThickLoc, config.ColorThick.x, config.ColorThick.y, config.ColorThick.z, config.ColorThick.w);
+        glUniform1f(m_gridMinPixelsBetweenCellsLoc, config.MinPixelsBetweenCells);
+    }
 
-        GLint colorThinUniform = glGetUniformLocation(m_gridProgram, "gGridColorThin");
-        glUniform4f(colorThinUniform, config.ColorThin.x, config.ColorThin.y, config.ColorThin.z, config.ColorThin.w);
+    void renderGrid()
+    {
+        TRACE_SCOPE("Grid::renderGrid");
 
-        GLint colorThickUniform = glGetUniformLocation(m_gridProgram, "gGridColorThick");
-        glUniform4f(colorThickUniform, config.ColorThick.x, config.ColorThick.y, config.ColorThick.z, config.ColorThick.w);
+        // Created by init(); a program that failed to build was reported once when it was completed
+        if (m_pGridTechnique == nullptr || !m_pGridTechnique->Enable()) {
+            return;
+        }
 
-        GLint minPixelsUniform = glGetUniformLocation(m_gridProgram, "gGridMinPixelsBetweenCells");
-        glUniform1f(minPixelsUniform, config.MinPixelsBetweenCells);
+        // Camera state comes from the FrameData uniform block, only the grid settings are set here
+        m_pGridTechnique->SetConfig(config);
 
         // Render using glDrawArrays
         glEnable(GL_BLEND);
@@ -211,6 +199,23 @@ namespace Grid
         glDisable(GL_BLEND);
 
         // Unbind the shader program
+        glBindVertexArray(0);
         glUseProgram(0);
     }
+
+    // Issues the grid program at startup so it compiles alongside the model import; it is
+    // completed on its first Enable() in renderGrid(). Call once the context is current.
+    bool init()
+    {
+        m_pGridTechnique = new GridTechnique();
+        m_pGridTechnique->SetDeferredCompletion(true);
+        return m_pGridTechnique->Init();
+    }
+
+    // Must run while the GL context is still current
+    void shutdown()
+    {
+        delete m_pGridTechnique;
+        m_pGridTechnique = nullptr;
+    }
 };
\ No newline at end of file
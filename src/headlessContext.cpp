@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <cstring>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "headlessContext.hpp"
+#include "utils.hpp"
+
+static bool hasExtension(const char* pExtensions, const char* pName)
+{
+    if (pExtensions == nullptr) {
+        return false;
+    }
+
+    size_t length = strlen(pName);
+
+    for (const char* p = strstr(pExtensions, pName); p; p = strstr(p + length, pName)) {
+        bool startsWord = p == pExtensions || p[-1] == ' ';
+        bool endsWord = p[length] == ' ' || p[length] == '\0';
+        if (startsWord && endsWord) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    if (m_display == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (m_surface != EGL_NO_SURFACE) {
+        eglDestroySurface(m_display, m_surface);
+    }
+
+    if (m_context != EGL_NO_CONTEXT) {
+        eglDestroyContext(m_display, m_context);
+    }
+
+    eglTerminate(m_display);
+}
+
+bool HeadlessContext::initDisplay()
+{
+    const char* pClientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    auto eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    auto eglQueryDevicesEXT = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+
+    EGLint major, minor;
+
+    if (eglGetPlatformDisplayEXT && eglQueryDevicesEXT && hasExtension(pClientExtensions, "EGL_EXT_platform_device")) {
+        EGLDeviceEXT device;
+        EGLint numDevices = 0;
+
+        if (eglQueryDevicesEXT(1, &device, &numDevices) && numDevices > 0) {
+            m_display = eglGetPlatformDisplayEXT(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+            if (m_display != EGL_NO_DISPLAY && eglInitialize(m_display, &major, &minor)) {
+                m_pPlatformName = "device";
+                return true;
+            }
+        }
+    }
+
+    if (eglGetPlatformDisplayEXT && hasExtension(pClientExtensions, "EGL_MESA_platform_surfaceless")) {
+        m_display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (m_display != EGL_NO_DISPLAY && eglInitialize(m_display, &major, &minor)) {
+            m_pPlatformName = "surfaceless";
+            return true;
+        }
+    }
+
+    m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (m_display != EGL_NO_DISPLAY && eglInitialize(m_display, &major, &minor)) {
+        m_pPlatformName = "default";
+        return true;
+    }
+
+    m_display = EGL_NO_DISPLAY;
+    return false;
+}
+
+bool HeadlessContext::init(int majorVersion, int minorVersion)
+{
+    if (!initDisplay()) {
+        printf(RED_TEXT "EGL: no display could be initialized (error 0x%x)" RESET_TEXT "\n", eglGetError());
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        printf(RED_TEXT "EGL: desktop OpenGL is not supported on the %s display" RESET_TEXT "\n", m_pPlatformName);
+        return false;
+    }
+
+    bool surfaceless = hasExtension(eglQueryString(m_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+    // Color and depth live in the offscreen framebuffer, the config only has to allow desktop GL
+    const EGLint configAttribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(m_display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        printf(RED_TEXT "EGL: no OpenGL config on the %s display" RESET_TEXT "\n", m_pPlatformName);
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (m_context == EGL_NO_CONTEXT) {
+        printf(RED_TEXT "EGL: failed to create an OpenGL %d.%d core context (error 0x%x)" RESET_TEXT "\n", majorVersion, minorVersion, eglGetError());
+        return false;
+    }
+
+    if (!surfaceless) {
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        m_surface = eglCreatePbufferSurface(m_display, config, pbufferAttribs);
+        if (m_surface == EGL_NO_SURFACE) {
+            printf(RED_TEXT "EGL: failed to create a pbuffer (error 0x%x)" RESET_TEXT "\n", eglGetError());
+            return false;
+        }
+    }
+
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+        printf(RED_TEXT "EGL: failed to make the context current (error 0x%x)" RESET_TEXT "\n", eglGetError());
+        return false;
+    }
+
+    printf("EGL: OpenGL %d.%d context on the %s display%s\n", majorVersion, minorVersion, m_pPlatformName, surfaceless ? ", surfaceless" : "");
+
+    return true;
+}
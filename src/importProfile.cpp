@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "importProfile.hpp"
+
+// Mirrors the order of Assimp's PostStepRegistry. SplitLargeMeshes sits at its vertex-limit
+// position; its triangle-limit half runs earlier in a combined import, which only matters
+// for meshes that exceed the triangle limit.
+static const struct {
+    unsigned int Flag;
+    const char* Name;
+} PIPELINE_ORDER[] = {
+    { aiProcess_MakeLeftHanded, "MakeLeftHanded" },
+    { aiProcess_FlipUVs, "FlipUVs" },
+    { aiProcess_FlipWindingOrder, "FlipWindingOrder" },
+    { aiProcess_RemoveComponent, "RemoveComponent" },
+    { aiProcess_RemoveRedundantMaterials, "RemoveRedundantMaterials" },
+    { aiProcess_FindInstances, "FindInstances" },
+    { aiProcess_OptimizeGraph, "OptimizeGraph" },
+    { aiProcess_FindDegenerates, "FindDegenerates" },
+    { aiProcess_GenUVCoords, "GenUVCoords" },
+    { aiProcess_TransformUVCoords, "TransformUVCoords" },
+    { aiProcess_PreTransformVertices, "PreTransformVertices" },
+    { aiProcess_Triangulate, "Triangulate" },
+    { aiProcess_SortByPType, "SortByPType" },
+    { aiProcess_FindInvalidData, "FindInvalidData" },
+    { aiProcess_OptimizeMeshes, "OptimizeMeshes" },
+    { aiProcess_FixInfacingNormals, "FixInfacingNormals" },
+    { aiProcess_SplitByBoneCount, "SplitByBoneCount" },
+    { aiProcess_GenNormals, "GenNormals" },
+    { aiProcess_GenSmoothNormals, "GenSmoothNormals" },
+    { aiProcess_CalcTangentSpace, "CalcTangentSpace" },
+    { aiProcess_JoinIdenticalVertices, "JoinIdenticalVertices" },
+    { aiProcess_SplitLargeMeshes, "SplitLargeMeshes" },
+    { aiProcess_Debone, "Debone" },
+    { aiProcess_LimitBoneWeights, "LimitBoneWeights" },
+    { aiProcess_ImproveCacheLocality, "ImproveCacheLocality" },
+    { aiProcess_GenBoundingBoxes, "GenBoundingBoxes" },
+};
+
+unsigned int ImportProfile::getFlags(IMPORT_PROFILE profile)
+{
+    switch (profile) {
+    case IMPORT_PROFILE_FAST_PREVIEW:
+        return aiProcess_Triangulate |
+               aiProcess_JoinIdenticalVertices |
+               aiProcess_GenSmoothNormals;
+
+    case IMPORT_PROFILE_COLLISION_ONLY:
+        return aiProcess_Triangulate |
+               aiProcess_JoinIdenticalVertices |
+               aiProcess_FindDegenerates |
+               aiProcess_FindInvalidData;
+
+    case IMPORT_PROFILE_RENDER_QUALITY:
+    default:
+        return aiProcess_JoinIdenticalVertices |
+               aiProcess_Triangulate |
+               aiProcess_GenSmoothNormals |
+               aiProcess_LimitBoneWeights |
+               aiProcess_SplitLargeMeshes |
+               aiProcess_ImproveCacheLocality |
+               aiProcess_RemoveRedundantMaterials |
+               aiProcess_FindDegenerates |
+               aiProcess_FindInvalidData;
+    }
+}
+
+const char* ImportProfile::getName(IMPORT_PROFILE profile)
+{
+    switch (profile) {
+    case IMPORT_PROFILE_FAST_PREVIEW:   return "fast-preview";
+    case IMPORT_PROFILE_COLLISION_ONLY: return "collision-only";
+    default:                            return "render-quality";
+    }
+}
+
+bool ImportProfile::parse(const std::string& name, IMPORT_PROFILE& profile)
+{
+    for (IMPORT_PROFILE candidate : { IMPORT_PROFILE_FAST_PREVIEW, IMPORT_PROFILE_RENDER_QUALITY, IMPORT_PROFILE_COLLISION_ONLY }) {
+        if (name == getName(candidate)) {
+            profile = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const aiScene* ImportProfile::readFileByStep(Assimp::Importer& importer, const std::string& filename,
+                                             unsigned int flags, std::vector<StepTiming>& timings)
+{
+    timings.clear();
+
+    auto start = std::chrono::steady_clock::now();
+    const aiScene* pScene = importer.ReadFile(filename.c_str(), 0);
+    auto end = std::chrono::steady_clock::now();
+
+    timings.push_back({ "ReadFile", std::chrono::duration<double, std::milli>(end - start).count() });
+
+    for (const auto& step : PIPELINE_ORDER) {
+        if (!pScene || !(flags & step.Flag)) {
+            continue;
+        }
+
+        start = std::chrono::steady_clock::now();
+        pScene = importer.ApplyPostProcessing(step.Flag);
+        end = std::chrono::steady_clock::now();
+
+        timings.push_back({ step.Name, std::chrono::duration<double, std::milli>(end - start).count() });
+    }
+
+    return pScene;
+}
+
+void ImportProfile::printTimings(const std::vector<StepTiming>& timings)
+{
+    double total = 0.0;
+    for (const StepTiming& timing : timings) {
+        total += timing.Ms;
+    }
+
+    printf("Import steps\n");
+    printf("%-26s %10s %7s\n", "step", "ms", "share");
+
+    for (const StepTiming& timing : timings) {
+        printf("%-26s %10.2f %6.1f%%\n", timing.Name.c_str(), timing.Ms, total > 0.0 ? 100.0 * timing.Ms / total : 0.0);
+    }
+
+    printf("%-26s %10.2f\n", "total", total);
+}
+
+bool ImportProgressHandler::Update(float percentage)
+{
+    if (percentage >= 0.0f) {
+        m_progress = std::min(percentage, 1.0f);
+    }
+
+    // Returning false would cancel the import
+    return true;
+}
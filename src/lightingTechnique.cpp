@@ -0,0 +1,212 @@
+#include <string>
+
+#include "frameUniforms.hpp"
+#include "lightingTechnique.hpp"
+
+// Compiled with a preamble from LightingTechnique::Init() that picks the #version and defines
+// QUANTIZED_VERTICES for Mesh::VERTEX_FORMAT_QUANTIZED, INDIRECT_DRAW for Mesh::renderIndirect()
+// and NORMAL_MATRIX_IN_SHADER for the per-vertex inverse kept as a benchmark baseline
+static const char* pVertexShaderSource = R"(
+#ifdef QUANTIZED_VERTICES
+layout (location = 0) in vec3 aPos;    // unorm16 within the sub-mesh bounds
+layout (location = 2) in vec2 aNormal; // octahedral snorm8
+#else
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec3 aNormal;
+#endif
+
+out vec3 FragPos;
+out vec3 Normal;
+flat out vec3 ObjectColor;
+
+#ifdef INDIRECT_DRAW
+// Instanced attribute read at the command's baseInstance, which Mesh sets to the sub-mesh index
+layout (location = DRAW_ID_LOCATION) in uint aDrawID;
+
+struct DrawData
+{
+    mat4 Model;
+    mat4 NormalMatrix; // upper 3x3 used
+    vec4 Color;
+    vec4 QuantMin;
+    vec4 QuantExtent;
+};
+
+layout (std430, binding = DRAW_DATA_BINDING) readonly buffer DrawBuffer
+{
+    DrawData gDraws[];
+};
+#else
+uniform mat4 model;
+uniform mat3 normalMatrix;
+uniform vec3 objectColor;
+uniform vec3 quantMin;
+uniform vec3 quantExtent;
+#endif
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        vec2 signs = mix(vec2(-1.0), vec2(1.0), greaterThanEqual(n.xy, vec2(0.0)));
+        n.xy = (1.0 - abs(n.yx)) * signs;
+    }
+    return normalize(n);
+}
+
+void main()
+{
+#ifdef INDIRECT_DRAW
+    mat4 model = gDraws[aDrawID].Model;
+    mat3 normalMatrix = mat3(gDraws[aDrawID].NormalMatrix);
+    vec3 objectColor = gDraws[aDrawID].Color.rgb;
+    vec3 quantMin = gDraws[aDrawID].QuantMin.xyz;
+    vec3 quantExtent = gDraws[aDrawID].QuantExtent.xyz;
+#endif
+
+#ifdef QUANTIZED_VERTICES
+    vec3 position = quantMin + aPos * quantExtent;
+    vec3 normal = octDecode(aNormal);
+#else
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+#endif
+
+    FragPos = vec3(model * vec4(position, 1.0));
+#ifdef NORMAL_MATRIX_IN_SHADER
+    Normal = mat3(transpose(inverse(model))) * normal;
+#else
+    Normal = normalMatrix * normal;
+#endif
+    ObjectColor = objectColor;
+
+    gl_Position = gViewProjection * model * vec4(position, 1.0);
+}
+)";
+
+static const char* pFragmentShaderSource = R"(
+in vec3 FragPos;  // Position of the fragment
+in vec3 Normal;   // Normal at the fragment
+flat in vec3 ObjectColor; // Color of the object
+
+out vec4 FragColor;
+
+void main()
+{
+    vec3 lightPos = gLightPos.xyz;     // Position of the light
+    vec3 lightColor = gLightColor.xyz; // Color of the light
+    vec3 viewPos = gViewPos.xyz;       // Position of the viewer/camera
+
+    // Normalize the normal vector
+    vec3 norm = normalize(Normal);
+
+    // Calculate light direction
+    vec3 lightDir = normalize(lightPos - FragPos);
+
+    // Calculate view direction
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    // Diffuse lighting
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * lightColor;
+
+    // Specular lighting
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32); // Shininess factor
+    vec3 specular = spec * lightColor;
+
+    // Ambient lighting
+    vec3 ambient = 1 * vec3(1.0, 1.0, 1.0); // Adjust the ambient intensity
+
+    // Calculate attenuation
+    float distance = length(lightPos - FragPos);
+    float attenuation = 1.0 / (gAttenuation.x + gAttenuation.y * distance + gAttenuation.z * (distance * distance));
+
+    // Combine all lighting components with attenuation
+    vec3 result = (ambient + diffuse + specular) * ObjectColor * attenuation;
+
+    FragColor = vec4(result, 1.0);
+}
+)";
+
+bool LightingTechnique::Init()
+{
+    if (!Technique::Init()) {
+        return false;
+    }
+
+    // Shader storage buffers need GLSL 4.30, the direct path stays on 3.30
+    std::string preamble = m_indirect ? "#version 430 core\n" : "#version 330 core\n";
+
+    if (m_quantized) {
+        preamble += "#define QUANTIZED_VERTICES\n";
+    }
+
+    if (m_normalMatrixInShader) {
+        preamble += "#define NORMAL_MATRIX_IN_SHADER\n";
+    }
+
+    if (m_indirect) {
+        preamble += "#define INDIRECT_DRAW\n";
+        preamble += "#define DRAW_ID_LOCATION " + std::to_string(DRAW_ID_LOCATION) + "\n";
+        preamble += "#define DRAW_DATA_BINDING " + std::to_string(DRAW_DATA_BINDING) + "\n";
+    }
+
+    preamble += FRAME_DATA_GLSL;
+
+    std::string vertexSource = preamble + pVertexShaderSource;
+    std::string fragmentSource = preamble + pFragmentShaderSource;
+
+    if (!AddShaderSource(GL_VERTEX_SHADER, vertexSource.c_str(), m_indirect ? "lighting-indirect.vs" : "lighting.vs")) {
+        return false;
+    }
+
+    if (!AddShaderSource(GL_FRAGMENT_SHADER, fragmentSource.c_str(), "lighting.fs")) {
+        return false;
+    }
+
+    return Finalize();
+}
+
+bool LightingTechnique::OnLinked()
+{
+    // Per-draw state comes from the shader storage buffer in indirect mode
+    if (m_indirect) {
+        return true;
+    }
+
+    GET_UNIFORM_AND_CHECK(m_modelLoc, "model");
+    GET_UNIFORM_AND_CHECK(m_objectColorLoc, "objectColor");
+
+    if (!m_normalMatrixInShader) {
+        GET_UNIFORM_AND_CHECK(m_normalMatrixLoc, "normalMatrix");
+    }
+
+    if (m_quantized) {
+        GET_UNIFORM_AND_CHECK(m_quantMinLoc, "quantMin");
+        GET_UNIFORM_AND_CHECK(m_quantExtentLoc, "quantExtent");
+    }
+
+    return true;
+}
+
+void LightingTechnique::SetModel(const glm::mat4& model)
+{
+    glUniformMatrix4fv(m_modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+}
+
+void LightingTechnique::SetNormalMatrix(const glm::mat3& normalMatrix)
+{
+    glUniformMatrix3fv(m_normalMatrixLoc, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+}
+
+void LightingTechnique::SetObjectColor(const glm::vec3& color)
+{
+    glUniform3fv(m_objectColorLoc, 1, glm::value_ptr(color));
+}
+
+void LightingTechnique::SetQuantization(const glm::vec3& min, const glm::vec3& extent)
+{
+    glUniform3fv(m_quantMinLoc, 1, glm::value_ptr(min));
+    glUniform3fv(m_quantExtentLoc, 1, glm::value_ptr(extent));
+}
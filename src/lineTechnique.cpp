@@ -0,0 +1,42 @@
+#include "frameUniforms.hpp"
+#include "lineTechnique.hpp"
+
+static const char* pVertexShaderSource = "#version 330 core\n" FRAME_DATA_GLSL R"(
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aColor;
+
+out vec4 Color;
+
+void main() {
+    Color = aColor;
+    gl_Position = gViewProjection * vec4(aPos, 1.0);
+}
+)";
+
+static const char* pFragmentShaderSource = R"(
+#version 330 core
+in vec4 Color;
+
+out vec4 FragColor;
+
+void main() {
+    FragColor = Color;
+}
+)";
+
+bool LineTechnique::Init()
+{
+    if (!Technique::Init()) {
+        return false;
+    }
+
+    if (!AddShaderSource(GL_VERTEX_SHADER, pVertexShaderSource, "line.vs")) {
+        return false;
+    }
+
+    if (!AddShaderSource(GL_FRAGMENT_SHADER, pFragmentShaderSource, "line.fs")) {
+        return false;
+    }
+
+    return Finalize();
+}
@@ -2,15 +2,167 @@
 #include "mesh.hpp"
 #include "utils.hpp"
 
+// "yaw,pitch,distance" or "yaw,pitch,distance,targetX,targetY,targetZ"
+static bool parsePose(const std::string& text, OrbitPose& pose)
+{
+    float values[6];
+    int count = sscanf(text.c_str(), "%f,%f,%f,%f,%f,%f", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5]);
+
+    if (count != 3 && count != 6) {
+        return false;
+    }
+
+    pose.Yaw = values[0];
+    pose.Pitch = values[1];
+    pose.Distance = values[2];
+    if (count == 6) {
+        pose.Target = glm::vec3(values[3], values[4], values[5]);
+    }
+
+    return true;
+}
+
 int main(int argc, char *argv[])
 {
+    // Startup is measured from here to the first presented frame, see Gizmo::reportLoadTimings()
+    auto launchTime = std::chrono::steady_clock::now();
+
     int runForSeconds = 45;
+    bool indirectDraw = false;
+    bool renderOnDemand = false;
+    bool benchNormalMatrix = false;
+    std::string headlessDir;
+    int headlessFrames = 0;
+    int headlessWidth = WINDOW_WIDTH;
+    int headlessHeight = WINDOW_HEIGHT;
+    std::vector<OrbitPose> poses;
+    std::string capturePath;
+    Mesh::LoadOptions loadOptions;
 
-    if (argc > 1)
+    for (int i = 1; i < argc; i++)
     {
+        std::string arg = argv[i];
+
+        if (arg == "--async")
+        {
+            loadOptions.Async = true;
+            continue;
+        }
+
+        if (arg == "--optimize")
+        {
+            loadOptions.Optimize = true;
+            continue;
+        }
+
+        if (arg == "--lods")
+        {
+            loadOptions.GenerateLods = true;
+            continue;
+        }
+
+        if (arg == "--drop-cpu-geometry")
+        {
+            loadOptions.KeepCpuGeometry = false;
+            continue;
+        }
+
+        if (arg == "--import-profile" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if (!ImportProfile::parse(name, loadOptions.ImportProfile))
+            {
+                std::string title = "Unknown import profile '" + name + "'. Using " + ImportProfile::getName(loadOptions.ImportProfile) + ".";
+                std::cout << "\033[35m" << title << "\033[0m" << std::endl;
+            }
+            continue;
+        }
+
+        if (arg == "--time-import-steps")
+        {
+            loadOptions.TimeImportSteps = true;
+            continue;
+        }
+
+        if (arg == "--quantized")
+        {
+            loadOptions.VertexFormat = Mesh::VERTEX_FORMAT_QUANTIZED;
+            continue;
+        }
+
+        if (arg == "--indirect")
+        {
+            indirectDraw = true;
+            continue;
+        }
+
+        if (arg == "--on-demand")
+        {
+            renderOnDemand = true;
+            continue;
+        }
+
+        if (arg == "--headless" && i + 1 < argc)
+        {
+            headlessDir = argv[++i];
+            continue;
+        }
+
+        if (arg == "--frames" && i + 1 < argc)
+        {
+            headlessFrames = std::max(1, atoi(argv[++i]));
+            continue;
+        }
+
+        if (arg == "--size" && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &headlessWidth, &headlessHeight) != 2 || headlessWidth <= 0 || headlessHeight <= 0)
+            {
+                std::cout << "\033[35m" << "Invalid size, expected WIDTHxHEIGHT" << "\033[0m" << std::endl;
+                return -1;
+            }
+            continue;
+        }
+
+        if (arg == "--pose" && i + 1 < argc)
+        {
+            OrbitPose pose;
+            if (!parsePose(argv[++i], pose))
+            {
+                std::cout << "\033[35m" << "Invalid pose, expected yaw,pitch,distance[,x,y,z]" << "\033[0m" << std::endl;
+                return -1;
+            }
+            poses.push_back(pose);
+            continue;
+        }
+
+        if (arg == "--capture" && i + 1 < argc)
+        {
+            capturePath = argv[++i];
+            continue;
+        }
+
+        if (arg == "--no-program-cache")
+        {
+            ProgramCache::instance().setEnabled(false);
+            continue;
+        }
+
+        if (arg == "--bench-normal-matrix")
+        {
+            benchNormalMatrix = true;
+            continue;
+        }
+
+        if (arg == "--bench-hierarchy")
+        {
+            Mesh::benchmarkHierarchy(50000);
+            return 0;
+        }
+
         try
         {
-            runForSeconds = std::stoi(argv[1]);
+            runForSeconds = std::stoi(arg);
         }
         catch (const std::invalid_argument& e)
         {
@@ -24,16 +176,61 @@ int main(int argc, char *argv[])
     const std::string filePath = utils::disk::getCurrentDirectory() + "/models/CRX10_axis1.glb";
 
     std::shared_ptr<Gizmo> gizmo = std::make_shared<Gizmo>();
+    gizmo->setLaunchTime(launchTime);
+
+    // Offscreen rendering for machines without a display: one PNG per frame, then exit
+    if (!headlessDir.empty())
+    {
+        // Headless mode already writes every frame, the recorder only runs in the window loop
+        if (!capturePath.empty())
+        {
+            std::cout << "\033[35m" << "--capture records the window, it cannot be combined with --headless" << "\033[0m" << std::endl;
+            return -1;
+        }
+
+        if (renderOnDemand || benchNormalMatrix)
+        {
+            std::string flag = renderOnDemand ? "--on-demand" : "--bench-normal-matrix";
+            std::cout << "\033[35m" << flag << " only applies to the window loop, it cannot be combined with --headless" << "\033[0m" << std::endl;
+            return -1;
+        }
+
+        if (gizmo->initHeadless(headlessWidth, headlessHeight) != 0)
+        {
+            std::cerr << "Failed to initialize headless rendering" << std::endl;
+            return -1;
+        }
+
+        gizmo->setIndirectDraw(indirectDraw);
+        utils::printGLVersion();
+        int numFrames = headlessFrames > 0 ? headlessFrames : std::max<int>(1, poses.size());
+        bool rendered = gizmo->loadModel(filePath, loadOptions) && gizmo->renderHeadless(poses, numFrames, headlessDir);
+
+        utils::format::printEnd();
+        return rendered ? 0 : 1;
+    }
+
     if (gizmo->init() != 0)
     {
         std::cerr << "Failed to initialize Gizmo" << std::endl;
         return -1;
     }
 
+    gizmo->setIndirectDraw(indirectDraw);
+    gizmo->setRenderOnDemand(renderOnDemand);
+    if (!capturePath.empty())
+    {
+        gizmo->startCapture(capturePath);
+    }
+
     // gizmo.loadModel(filePath);
     // gizmo.loadMesh(filePath);
     utils::printGLVersion();
-    if (gizmo->loadModel(filePath)) gizmo->run(runForSeconds);
+    if (benchNormalMatrix)
+    {
+        if (gizmo->loadModel(filePath, loadOptions)) gizmo->benchmarkNormalMatrix(200);
+    }
+    else if (gizmo->loadModel(filePath, loadOptions)) gizmo->run(runForSeconds);
     
     utils::format::printEnd();
 
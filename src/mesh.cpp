@@ -1,9 +1,13 @@
 #include "mesh.hpp"
+#include "trace.hpp"
 
 #define POSITION_LOCATION  0
 #define TEX_COORD_LOCATION 1
 #define NORMAL_LOCATION    2
 
+// Triangle budget of each LOD relative to the full-resolution sub-mesh
+static const float LOD_TRIANGLE_RATIOS[MAX_LODS] = { 0.5f, 0.25f, 0.1f };
+
 std::string GetFullPath(const std::string& dir, const aiString& Path)
 {
     std::string p(Path.data);
@@ -20,12 +24,42 @@ std::string GetFullPath(const std::string& dir, const aiString& Path)
     return FullPath;
 }
 
+// Octahedral mapping: folds the unit sphere onto the [-1, 1] square
+static void encodeOctahedral(const Vector3f& n, int8_t out[2])
+{
+    float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    float x = l1 > 0.0f ? n.x / l1 : 0.0f;
+    float y = l1 > 0.0f ? n.y / l1 : 0.0f;
+
+    if (n.z < 0.0f) {
+        float ox = x;
+        x = (1.0f - fabsf(y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - fabsf(ox)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    out[0] = static_cast<int8_t>(roundf(std::clamp(x, -1.0f, 1.0f) * 127.0f));
+    out[1] = static_cast<int8_t>(roundf(std::clamp(y, -1.0f, 1.0f) * 127.0f));
+}
+
+static uint16_t quantizeUnorm16(float value, float min, float extent)
+{
+    float t = extent > 0.0f ? (value - min) / extent : 0.0f;
+    return static_cast<uint16_t>(roundf(std::clamp(t, 0.0f, 1.0f) * 65535.0f));
+}
+
 Mesh::Mesh()
-{ 
+{
+    m_pImportProgress = new ImportProgressHandler();
+    m_importer.SetProgressHandler(m_pImportProgress);
 }
 
 Mesh::~Mesh()
 {
+    // Assimp cannot be interrupted, so an in-flight import has to finish first
+    if (m_loadThread.joinable()) {
+        m_loadThread.join();
+    }
+
     clear();
 }
 
@@ -55,13 +89,15 @@ void Mesh::countVerticesAndIndices(aiNode* node, const aiScene* scene, unsigned
         m_meshes[meshIndex].Name = paiMesh->mName.C_Str();
         m_meshes[meshIndex].MaterialIndex = paiMesh->mMaterialIndex;
         m_meshes[meshIndex].NumIndices = paiMesh->mNumFaces * 3;
+        m_meshes[meshIndex].NumVertices = paiMesh->mNumVertices;
         m_meshes[meshIndex].BaseVertex = numVertices;
         m_meshes[meshIndex].BaseIndex = numIndices;
         m_meshes[meshIndex].Transform = globalTransform;
+        m_meshes[meshIndex].LodIndexCapacity = getLodIndexCapacity(m_meshes[meshIndex].NumIndices);
 
         // Update the total counts
         numVertices += paiMesh->mNumVertices;
-        numIndices += m_meshes[meshIndex].NumIndices;
+        numIndices += m_meshes[meshIndex].getIndexRange();
     }
 
     // Recursively process child nodes
@@ -78,6 +114,8 @@ void Mesh::reserveSpace(unsigned int numVertices, unsigned int numIndices)
 
 bool Mesh::initScene(const aiScene* pScene, const std::string& filename)
 {
+    TRACE_SCOPE("Mesh::initScene");
+
     unsigned int numVertices = 0;
     unsigned int numIndices = 0;
 
@@ -90,18 +128,241 @@ bool Mesh::initScene(const aiScene* pScene, const std::string& filename)
     }
     
     countVerticesAndIndices(pScene->mRootNode, pScene, numVertices, numIndices, identity);
+    buildNameIndex();
     reserveSpace(numVertices, numIndices);
+
+    // The reserve above guarantees these pointers stay valid while processNode appends
+    m_pSourceVertices = m_vertices.data();
+    m_pSourceIndices = m_indices.data();
+    m_numVertices = numVertices;
+    m_numIndices = numIndices;
+    publishLayout();
+
     processNode(pScene->mRootNode, pScene);
-    extractTrianglesFromScene();
-    populateBuffers();
+    waitForTextures();
 
-    return GL_CHECK_ERROR();
+    return true;
+}
+
+bool Mesh::initFromCache(const MeshCache& cache)
+{
+    const MeshCache::Header& header = cache.getHeader();
+    const MeshCache::MeshRecord* pMeshes = cache.getMeshes();
+    const MeshCache::MaterialRecord* pMaterials = cache.getMaterials();
+
+    m_meshes.resize(header.NumMeshes);
+    m_materials.resize(header.NumMaterials);
+
+    for (uint32_t i = 0; i < header.NumMeshes; i++) {
+        const MeshCache::MeshRecord& record = pMeshes[i];
+        MeshData& mesh = m_meshes[i];
+
+        mesh.Name = cache.getName(record);
+        mesh.NumIndices = record.NumIndices;
+        mesh.NumVertices = record.NumVertices;
+        mesh.BaseVertex = record.BaseVertex;
+        mesh.BaseIndex = record.BaseIndex;
+        mesh.MaterialIndex = record.MaterialIndex;
+        mesh.LodIndexCapacity = record.LodIndexCapacity;
+        memcpy(&mesh.Transform.a1, record.Transform, sizeof(record.Transform));
+
+        for (uint32_t level = 0; level < record.NumLods && level < MAX_LODS; level++) {
+            MeshData::Lod lod;
+            lod.BaseIndex = record.LodBaseIndex[level];
+            lod.NumIndices = record.LodNumIndices[level];
+            lod.Error = record.LodError[level];
+            mesh.Lods.push_back(lod);
+        }
+
+        if (record.Parent >= 0) {
+            mesh.Parent = &m_meshes[record.Parent];
+            mesh.Parent->Children.push_back(&mesh);
+        }
+    }
+
+    for (uint32_t i = 0; i < header.NumMaterials; i++) {
+        const MeshCache::MaterialRecord& record = pMaterials[i];
+        m_materials[i].AmbientColor = Vector4f(record.Ambient[0], record.Ambient[1], record.Ambient[2], record.Ambient[3]);
+        m_materials[i].DiffuseColor = Vector4f(record.Diffuse[0], record.Diffuse[1], record.Diffuse[2], record.Diffuse[3]);
+        m_materials[i].SpecularColor = Vector4f(record.Specular[0], record.Specular[1], record.Specular[2], record.Specular[3]);
+    }
+
+    m_pSourceVertices = static_cast<const Vertex*>(cache.getVertices());
+    m_pSourceIndices = cache.getIndices();
+    m_numVertices = header.NumVertices;
+    m_numIndices = header.NumIndices;
+    publishLayout();
+
+    for (uint32_t i = 0; i < header.NumMeshes; i++) {
+        publishSubMesh(i);
+    }
+
+    return true;
+}
+
+void Mesh::publishLayout()
+{
+    prepareLayout();
+
+    std::lock_guard<std::mutex> lock(m_loadMutex);
+    m_layoutReady = true;
+}
+
+void Mesh::publishSubMesh(uint meshIndex)
+{
+    prepareSubMesh(meshIndex);
+
+    std::lock_guard<std::mutex> lock(m_loadMutex);
+    m_readyMeshes.push_back(meshIndex);
+}
+
+// Assigns every sub-mesh its range in the GPU index buffer and sizes the packed copies.
+// Runs on the loader thread once the counts are known, before anything is uploaded.
+void Mesh::prepareLayout()
+{
+    if (m_vertexFormat == VERTEX_FORMAT_FLOAT) {
+        for (MeshData& mesh : m_meshes) {
+            mesh.IndexSize = sizeof(uint);
+            mesh.IndexByteOffset = sizeof(uint) * static_cast<size_t>(mesh.BaseIndex);
+        }
+
+        m_vertexBufferBytes = sizeof(Vertex) * static_cast<size_t>(m_numVertices);
+        m_indexBufferBytes = sizeof(uint) * static_cast<size_t>(m_numIndices);
+        return;
+    }
+
+    // Local indices of sub-meshes under 65k vertices fit in 16 bits. The 32-bit ranges go
+    // first so that every range stays aligned to its own index size.
+    size_t offset = 0;
+
+    for (MeshData& mesh : m_meshes) {
+        if (mesh.NumVertices > 65536) {
+            mesh.IndexSize = sizeof(uint32_t);
+            mesh.IndexByteOffset = offset;
+            offset += sizeof(uint32_t) * static_cast<size_t>(mesh.getIndexRange());
+        }
+    }
+
+    for (MeshData& mesh : m_meshes) {
+        if (mesh.NumVertices <= 65536) {
+            mesh.IndexSize = sizeof(uint16_t);
+            mesh.IndexByteOffset = offset;
+            offset += sizeof(uint16_t) * static_cast<size_t>(mesh.getIndexRange());
+        }
+    }
+
+    // Sized once up front: the GL thread reads published sub-meshes while later ones are still packed
+    m_quantizedVertices.assign(m_numVertices, QuantizedVertex());
+    m_packedIndices.assign(offset, 0);
+
+    m_vertexBufferBytes = sizeof(QuantizedVertex) * static_cast<size_t>(m_numVertices);
+    m_indexBufferBytes = offset;
+}
+
+// Computes the bounds of a sub-mesh and, for the quantized format, packs its vertices and indices
+void Mesh::prepareSubMesh(uint meshIndex)
+{
+    MeshData& mesh = m_meshes[meshIndex];
+    const Vertex* pVertices = m_pSourceVertices + mesh.BaseVertex;
+    const uint* pIndices = m_pSourceIndices + mesh.BaseIndex;
+
+    if (mesh.NumVertices > 0) {
+        mesh.AABBMin = glm::vec3(pVertices[0].position.x, pVertices[0].position.y, pVertices[0].position.z);
+        mesh.AABBMax = mesh.AABBMin;
+    }
+
+    for (uint i = 1; i < mesh.NumVertices; i++) {
+        glm::vec3 p(pVertices[i].position.x, pVertices[i].position.y, pVertices[i].position.z);
+        mesh.AABBMin = glm::min(mesh.AABBMin, p);
+        mesh.AABBMax = glm::max(mesh.AABBMax, p);
+    }
+
+    if (m_vertexFormat == VERTEX_FORMAT_FLOAT) {
+        return;
+    }
+
+    glm::vec3 extent = mesh.AABBMax - mesh.AABBMin;
+
+    for (uint i = 0; i < mesh.NumVertices; i++) {
+        const Vertex& v = pVertices[i];
+        QuantizedVertex& q = m_quantizedVertices[mesh.BaseVertex + i];
+
+        q.position[0] = quantizeUnorm16(v.position.x, mesh.AABBMin.x, extent.x);
+        q.position[1] = quantizeUnorm16(v.position.y, mesh.AABBMin.y, extent.y);
+        q.position[2] = quantizeUnorm16(v.position.z, mesh.AABBMin.z, extent.z);
+        encodeOctahedral(v.normal, q.normal);
+        q.texCoords[0] = glm::packHalf1x16(v.texCoords.x);
+        q.texCoords[1] = glm::packHalf1x16(v.texCoords.y);
+    }
+
+    unsigned char* pDest = m_packedIndices.data() + mesh.IndexByteOffset;
+
+    if (mesh.IndexSize == sizeof(uint16_t)) {
+        uint16_t* pShort = reinterpret_cast<uint16_t*>(pDest);
+        for (uint i = 0; i < mesh.getIndexRange(); i++) {
+            pShort[i] = static_cast<uint16_t>(pIndices[i]);
+        }
+    } else {
+        memcpy(pDest, pIndices, sizeof(uint32_t) * static_cast<size_t>(mesh.getIndexRange()));
+    }
+}
+
+void Mesh::printVertexFormatStats() const
+{
+    size_t floatVertexBytes = sizeof(Vertex) * static_cast<size_t>(m_numVertices);
+    size_t floatIndexBytes = sizeof(uint) * static_cast<size_t>(m_numIndices);
+    size_t floatBytes = floatVertexBytes + floatIndexBytes;
+    size_t gpuBytes = m_vertexBufferBytes + m_indexBufferBytes;
+    const double MB = 1024.0 * 1024.0;
+
+    if (m_vertexFormat == VERTEX_FORMAT_FLOAT || floatBytes == 0) {
+        printf("Vertex format: float, %.2f MB vertices + %.2f MB indices\n", floatVertexBytes / MB, floatIndexBytes / MB);
+        return;
+    }
+
+    uint numShortMeshes = 0;
+    for (const MeshData& mesh : m_meshes) {
+        if (mesh.IndexSize == sizeof(uint16_t)) {
+            numShortMeshes++;
+        }
+    }
+
+    // The bandwidth line is derived from the buffer sizes, assuming every sub-mesh is drawn once
+    // per frame at its full LOD; culling and LOD selection fetch less. It is not a measurement.
+    printf("Vertex format: quantized (%zu bytes/vertex, float %zu), 16-bit indices for %u of %zu sub-meshes\n",
+           sizeof(QuantizedVertex), sizeof(Vertex), numShortMeshes, m_meshes.size());
+    printf("%10s %12s %12s %8s\n", "", "float MB", "packed MB", "saved");
+    printf("%10s %12.2f %12.2f %7.1f%%\n", "vertices", floatVertexBytes / MB, m_vertexBufferBytes / MB,
+           floatVertexBytes ? 100.0 * (1.0 - (double)m_vertexBufferBytes / floatVertexBytes) : 0.0);
+    printf("%10s %12.2f %12.2f %7.1f%%\n", "indices", floatIndexBytes / MB, m_indexBufferBytes / MB,
+           floatIndexBytes ? 100.0 * (1.0 - (double)m_indexBufferBytes / floatIndexBytes) : 0.0);
+    printf("%10s %12.2f %12.2f %7.1f%%\n", "total", floatBytes / MB, gpuBytes / MB,
+           100.0 * (1.0 - (double)gpuBytes / floatBytes));
+    printf("Estimated geometry bandwidth: %.2f MB/frame (float %.2f MB), %.1f GB/s at an assumed 60 fps (float %.1f GB/s)\n",
+           gpuBytes / MB, floatBytes / MB, 60.0 * gpuBytes / (MB * 1024.0), 60.0 * floatBytes / (MB * 1024.0));
+}
+
+void Mesh::buildNameIndex()
+{
+    m_meshIndexByName.clear();
+    m_meshIndexByName.reserve(m_meshes.size());
+
+    // emplace keeps the first entry for duplicate names, matching MeshData::findByName
+    for (uint i = 0; i < m_meshes.size(); i++) {
+        m_meshIndexByName.emplace(m_meshes[i].Name, i);
+    }
+}
+
+MeshData* Mesh::findMeshByName(const aiString& name)
+{
+    auto it = m_meshIndexByName.find(name.C_Str());
+    return it != m_meshIndexByName.end() ? &m_meshes[it->second] : nullptr;
 }
 
 void Mesh::processNode(aiNode* node, const aiScene* scene, int level)
 {
-    MeshData* meshData = MeshData::findByName(m_meshes, node->mName);
-    MeshData* parentData = MeshData::findByName(m_meshes, node->mParent->mName);
+    MeshData* meshData = findMeshByName(node->mName);
+    MeshData* parentData = node->mParent ? findMeshByName(node->mParent->mName) : nullptr;
 
     if (meshData == nullptr) {
         printf(RED_TEXT "Error: MeshData not found for node '%s'" RESET_TEXT "\n", node->mName.C_Str());
@@ -113,10 +374,26 @@ void Mesh::processNode(aiNode* node, const aiScene* scene, int level)
         meshData->Parent = parentData;
     }
 
-    printf("%s%s %s\n", std::string(2 * level++, ' ').c_str(), meshData->Name.c_str(), meshData->printPosition().c_str());
+    if (m_printHierarchy) {
+        printf("%s%s %s\n", std::string(2 * level, ' ').c_str(), meshData->Name.c_str(), meshData->printPosition().c_str());
+    }
+    level++;
+
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
         const aiMesh* paiMesh = scene->mMeshes[node->mMeshes[i]];
         initSingleMesh(paiMesh);
+
+#ifdef GFX_USE_MESHOPTIMIZER
+        if (m_optimizeMeshes) {
+            optimizeSubMesh(node->mMeshes[i]);
+        }
+
+        if (m_generateLods) {
+            generateLods(node->mMeshes[i]);
+        }
+#endif
+
+        publishSubMesh(node->mMeshes[i]);
     }
 
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
@@ -159,8 +436,176 @@ void Mesh::initSingleMesh(const aiMesh* paiMesh)
     }
 }
 
+unsigned int Mesh::getImportFlags() const
+{
+    unsigned int flags = ImportProfile::getFlags(m_importProfile);
+
+    // The meshoptimizer stage reorders for the vertex cache itself
+    if (m_optimizeMeshes) {
+        flags &= ~aiProcess_ImproveCacheLocality;
+    }
+
+    return flags;
+}
+
+uint32_t Mesh::getPipelineFlags() const
+{
+    return (m_optimizeMeshes ? PIPELINE_OPTIMIZED : 0) | (m_generateLods ? PIPELINE_LODS : 0);
+}
+
+uint Mesh::getLodIndexCapacity(uint numIndices) const
+{
+    if (!m_generateLods) {
+        return 0;
+    }
+
+    uint capacity = 0;
+    for (float ratio : LOD_TRIANGLE_RATIOS) {
+        capacity += static_cast<uint>(numIndices / 3 * ratio) * 3;
+    }
+
+    return capacity;
+}
+
+#ifdef GFX_USE_MESHOPTIMIZER
+// Simplifies the sub-mesh just appended by initSingleMesh into its reserved LOD slots. Each level
+// starts from the full-resolution indices so its error is measured against the original surface.
+// A level the simplifier cannot bring under its budget is dropped, its slot stays zero-filled.
+void Mesh::generateLods(uint meshIndex)
+{
+    MeshData& mesh = m_meshes[meshIndex];
+    size_t end = m_indices.size() + mesh.LodIndexCapacity;
+
+    if (mesh.NumIndices > 0 && mesh.NumVertices > 0) {
+        // Both stay valid while appending, reserveSpace() covered the LOD slots
+        const uint* pIndices = m_indices.data() + mesh.BaseIndex;
+        const float* pPositions = &m_vertices[mesh.BaseVertex].position.x;
+
+        float scale = meshopt_simplifyScale(pPositions, mesh.NumVertices, sizeof(Vertex));
+        std::vector<uint> lodIndices(mesh.NumIndices);
+        size_t previousCount = mesh.NumIndices;
+
+        for (float ratio : LOD_TRIANGLE_RATIOS) {
+            size_t budget = static_cast<size_t>(mesh.NumIndices / 3 * ratio) * 3;
+            size_t slotStart = m_indices.size();
+            float error = 0.0f;
+
+            size_t count = budget >= 3 ? meshopt_simplify(lodIndices.data(), pIndices, mesh.NumIndices, pPositions,
+                                                          mesh.NumVertices, sizeof(Vertex), budget, 1.0f, 0, &error)
+                                       : 0;
+
+            if (count > 0 && count <= budget && count < previousCount) {
+                meshopt_optimizeVertexCache(lodIndices.data(), lodIndices.data(), count, mesh.NumVertices);
+                m_indices.insert(m_indices.end(), lodIndices.begin(), lodIndices.begin() + count);
+
+                MeshData::Lod lod;
+                lod.BaseIndex = static_cast<uint>(slotStart);
+                lod.NumIndices = static_cast<uint>(count);
+                lod.Error = error * scale;
+                mesh.Lods.push_back(lod);
+
+                previousCount = count;
+            }
+
+            m_indices.resize(slotStart + budget, 0);
+        }
+    }
+
+    m_indices.resize(end, 0);
+}
+#endif
+
+// Picks the coarsest level whose error, projected at the nearest point of the bounding sphere,
+// stays under m_lodPixelError. Errors grow monotonically along the chain.
+uint Mesh::selectLod(const MeshData& mesh, const glm::mat4& transform, const glm::vec3& cameraPos, float pixelsPerUnit) const
+{
+    if (mesh.Lods.empty()) {
+        return 0;
+    }
+
+    float scale = std::max({ glm::length(glm::vec3(transform[0])),
+                             glm::length(glm::vec3(transform[1])),
+                             glm::length(glm::vec3(transform[2])) });
+    glm::vec3 center = glm::vec3(transform * glm::vec4((mesh.AABBMin + mesh.AABBMax) * 0.5f, 1.0f));
+    float radius = glm::length(mesh.AABBMax - mesh.AABBMin) * 0.5f * scale;
+    float distance = std::max(glm::length(center - cameraPos) - radius, 1e-4f);
+
+    uint level = 0;
+    for (size_t i = 0; i < mesh.Lods.size(); i++) {
+        float pixels = mesh.Lods[i].Error * scale / distance * pixelsPerUnit;
+        if (pixels > m_lodPixelError) {
+            break;
+        }
+        level = static_cast<uint>(i + 1);
+    }
+
+    return level;
+}
+
+#ifdef GFX_USE_MESHOPTIMIZER
+// Reorders the sub-mesh just appended by initSingleMesh for the post-transform cache, then for
+// overdraw (allowing 5% cache loss), then reorders its vertices in first-use order for fetch locality
+void Mesh::optimizeSubMesh(uint meshIndex)
+{
+    const MeshData& mesh = m_meshes[meshIndex];
+    size_t numIndices = mesh.NumIndices;
+    size_t numVertices = mesh.NumVertices;
+
+    if (numIndices == 0 || numVertices == 0) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint* pIndices = m_indices.data() + mesh.BaseIndex;
+    Vertex* pVertices = m_vertices.data() + mesh.BaseVertex;
+
+    meshopt_VertexCacheStatistics cacheBefore = meshopt_analyzeVertexCache(pIndices, numIndices, numVertices, 16, 0, 0);
+    meshopt_VertexFetchStatistics fetchBefore = meshopt_analyzeVertexFetch(pIndices, numIndices, numVertices, sizeof(Vertex));
+
+    meshopt_optimizeVertexCache(pIndices, pIndices, numIndices, numVertices);
+    meshopt_optimizeOverdraw(pIndices, pIndices, numIndices, &pVertices[0].position.x, numVertices, sizeof(Vertex), 1.05f);
+
+    // Unreferenced vertices are left at the end of the range, BaseVertex of later sub-meshes is already published
+    std::vector<Vertex> reordered(numVertices);
+    size_t numUsed = meshopt_optimizeVertexFetch(reordered.data(), pIndices, numIndices, pVertices, numVertices, sizeof(Vertex));
+    std::copy(reordered.begin(), reordered.begin() + numUsed, pVertices);
+
+    meshopt_VertexCacheStatistics cacheAfter = meshopt_analyzeVertexCache(pIndices, numIndices, numVertices, 16, 0, 0);
+    meshopt_VertexFetchStatistics fetchAfter = meshopt_analyzeVertexFetch(pIndices, numIndices, numVertices, sizeof(Vertex));
+
+    m_optimizeStats.NumTriangles += numIndices / 3;
+    m_optimizeStats.NumVertices += numVertices;
+    m_optimizeStats.TransformedBefore += cacheBefore.vertices_transformed;
+    m_optimizeStats.TransformedAfter += cacheAfter.vertices_transformed;
+    m_optimizeStats.FetchedBefore += fetchBefore.bytes_fetched;
+    m_optimizeStats.FetchedAfter += fetchAfter.bytes_fetched;
+    m_optimizeStats.Ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+#endif
+
+void Mesh::printOptimizeStats() const
+{
+    const OptimizeStats& stats = m_optimizeStats;
+
+    if (stats.NumTriangles == 0 || stats.NumVertices == 0) {
+        return;
+    }
+
+    // ACMR: vertex shader invocations per triangle (0.5 is ideal), ATVR: per unique vertex (1.0 is ideal)
+    double vertexBytes = static_cast<double>(sizeof(Vertex) * stats.NumVertices);
+
+    printf("Mesh optimization: %lu triangles in %.2f ms\n", (unsigned long)stats.NumTriangles, stats.Ms);
+    printf("%10s %10s %10s\n", "", "before", "after");
+    printf("%10s %10.3f %10.3f\n", "ACMR", (double)stats.TransformedBefore / stats.NumTriangles, (double)stats.TransformedAfter / stats.NumTriangles);
+    printf("%10s %10.3f %10.3f\n", "ATVR", (double)stats.TransformedBefore / stats.NumVertices, (double)stats.TransformedAfter / stats.NumVertices);
+    printf("%10s %10.3f %10.3f\n", "overfetch", stats.FetchedBefore / vertexBytes, stats.FetchedAfter / vertexBytes);
+}
+
 bool Mesh::initMaterials(const aiScene* pScene, const std::string& filename)
 {
+    TRACE_SCOPE("Mesh::initMaterials");
+
     std::string dir = utils::disk::getDirFromFilename(filename);
 
     bool Ret = true;
@@ -175,10 +620,113 @@ bool Mesh::initMaterials(const aiScene* pScene, const std::string& filename)
         loadColors(pMaterial, i);
     }
 
+    decodeTextures();
+
     std::cout << std::string(40, '-') << std::endl;
     return Ret;
 }
 
+std::shared_ptr<Texture> Mesh::acquireTexture(const aiTexture* paiTexture, const std::string& fullPath, const char* kind, int materialIndex)
+{
+    TextureCache& cache = TextureCache::instance();
+    std::string key = paiTexture ? TextureCache::keyForEmbedded(paiTexture) : TextureCache::keyForFile(fullPath);
+
+    bool isNew = false;
+    std::shared_ptr<Texture> pTexture = cache.acquire(key, GL_TEXTURE_2D, fullPath, isNew);
+
+    // Only the first reference decodes and uploads; later ones share the GL texture
+    if (isNew) {
+        TextureJob job;
+        job.pTexture = pTexture.get();
+        job.paiTexture = paiTexture;
+        job.Kind = kind;
+        job.MaterialIndex = materialIndex;
+        m_textureJobs.push_back(job);
+    }
+
+    return pTexture;
+}
+
+// Starts decoding the queued textures in the background; geometry is assembled meanwhile
+void Mesh::decodeTextures()
+{
+    if (m_textureJobs.empty()) {
+        return;
+    }
+
+    m_textureDecodeStart = std::chrono::steady_clock::now();
+    m_pTexturePool = std::make_unique<ThreadPool>(std::min<unsigned int>(m_textureJobs.size(), std::thread::hardware_concurrency()));
+
+    for (TextureJob& job : m_textureJobs) {
+        m_pTexturePool->submit([&job]() {
+            auto decodeStart = std::chrono::steady_clock::now();
+
+            if (job.paiTexture) {
+                // Compressed embedded textures store their byte size in mWidth
+                job.Decoded = job.pTexture->Decode(job.paiTexture->mWidth, job.paiTexture->pcData);
+            } else {
+                job.Decoded = job.pTexture->Decode();
+            }
+
+            job.DecodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeStart).count();
+        });
+    }
+
+}
+
+void Mesh::waitForTextures()
+{
+    if (!m_pTexturePool) {
+        return;
+    }
+
+    m_pTexturePool->wait();
+
+    m_textureDecodeWallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_textureDecodeStart).count();
+    m_textureDecodeThreads = m_pTexturePool->getNumThreads();
+    m_pTexturePool.reset();
+}
+
+void Mesh::uploadTextures()
+{
+    if (m_textureJobs.empty()) {
+        return;
+    }
+
+    double decodeSumMs = 0.0;
+    double uploadSumMs = 0.0;
+
+    for (TextureJob& job : m_textureJobs) {
+        if (!job.Decoded) {
+            printf("Error loading %s texture '%s'\n", job.Kind, job.paiTexture ? job.paiTexture->achFormatHint : job.pTexture->GetFileName().c_str());
+            exit(0);
+        }
+
+        auto uploadStart = std::chrono::steady_clock::now();
+        job.pTexture->Upload();
+        job.UploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+
+        decodeSumMs += job.DecodeMs;
+        uploadSumMs += job.UploadMs;
+    }
+
+    printf("Texture timings (%zu textures, %u decode threads)\n", m_textureJobs.size(), m_textureDecodeThreads);
+
+    for (const TextureJob& job : m_textureJobs) {
+        int width, height;
+        job.pTexture->GetImageSize(width, height);
+
+        printf("  [mat %3d] %-9s %5dx%-5d bpp %d  decode %8.2f ms  upload %6.2f ms  %s\n",
+               job.MaterialIndex, job.Kind, width, height, job.pTexture->GetBPP(), job.DecodeMs, job.UploadMs,
+               job.paiTexture ? "<embedded>" : job.pTexture->GetFileName().c_str());
+    }
+
+    printf("  decode wall %.2f ms (serial sum %.2f ms), upload %.2f ms\n", m_textureDecodeWallMs, decodeSumMs, uploadSumMs);
+
+    m_textureJobs.clear();
+    TextureCache::instance().printStats();
+}
+
 void Mesh::loadTextures(const std::string& dir, const aiMaterial* pMaterial, int Index)
 {
     loadDiffuseTexture(dir, pMaterial, Index);
@@ -192,7 +740,7 @@ void Mesh::loadTextures(const std::string& dir, const aiMaterial* pMaterial, int
 
 void Mesh::loadDiffuseTexture(const std::string& dir, const aiMaterial* pMaterial, int materialIndex)
 {
-    m_materials[materialIndex].pDiffuse = NULL;
+    m_materials[materialIndex].pDiffuse = nullptr;
 
     if (pMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
         aiString Path;
@@ -212,29 +760,19 @@ void Mesh::loadDiffuseTexture(const std::string& dir, const aiMaterial* pMateria
 void Mesh::loadDiffuseTextureEmbedded(const aiTexture* paiTexture, int materialIndex)
 {
     printf("Embeddeded diffuse texture type '%s'\n", paiTexture->achFormatHint);
-    m_materials[materialIndex].pDiffuse = new Texture(GL_TEXTURE_2D);
-    int buffer_size = paiTexture->mWidth;
-    m_materials[materialIndex].pDiffuse->Load(buffer_size, paiTexture->pcData);
+    m_materials[materialIndex].pDiffuse = acquireTexture(paiTexture, "", "diffuse", materialIndex);
 }
 
 void Mesh::loadDiffuseTextureFromFile(const std::string& dir, const aiString& Path, int materialIndex)
 {
     std::string FullPath = GetFullPath(dir, Path);
 
-    m_materials[materialIndex].pDiffuse = new Texture(GL_TEXTURE_2D, FullPath.c_str());
-
-    if (!m_materials[materialIndex].pDiffuse->Load()) {
-        printf("Error loading diffuse texture '%s'\n", FullPath.c_str());
-        exit(0);
-    }
-    else {
-        printf("Loaded diffuse texture '%s' at index %d\n", FullPath.c_str(), materialIndex);
-    }
+    m_materials[materialIndex].pDiffuse = acquireTexture(NULL, FullPath, "diffuse", materialIndex);
 }
 
 void Mesh::loadSpecularTexture(const std::string& dir, const aiMaterial* pMaterial, int materialIndex)
 {
-    m_materials[materialIndex].pSpecularExponent = NULL;
+    m_materials[materialIndex].pSpecularExponent = nullptr;
 
     if (pMaterial->GetTextureCount(aiTextureType_SHININESS) > 0) {
         aiString Path;
@@ -254,29 +792,19 @@ void Mesh::loadSpecularTexture(const std::string& dir, const aiMaterial* pMateri
 void Mesh::loadSpecularTextureEmbedded(const aiTexture* paiTexture, int materialIndex)
 {
     printf("Embeddeded specular texture type '%s'\n", paiTexture->achFormatHint);
-    m_materials[materialIndex].pSpecularExponent = new Texture(GL_TEXTURE_2D);
-    int buffer_size = paiTexture->mWidth;
-    m_materials[materialIndex].pSpecularExponent->Load(buffer_size, paiTexture->pcData);
+    m_materials[materialIndex].pSpecularExponent = acquireTexture(paiTexture, "", "specular", materialIndex);
 }
 
 void Mesh::loadSpecularTextureFromFile(const std::string& dir, const aiString& Path, int materialIndex)
 {
     std::string FullPath = GetFullPath(dir, Path);
 
-    m_materials[materialIndex].pSpecularExponent = new Texture(GL_TEXTURE_2D, FullPath.c_str());
-
-    if (!m_materials[materialIndex].pSpecularExponent->Load()) {
-        printf("Error loading specular texture '%s'\n", FullPath.c_str());
-        exit(0);
-    }
-    else {
-        printf("Loaded specular texture '%s'\n", FullPath.c_str());
-    }
+    m_materials[materialIndex].pSpecularExponent = acquireTexture(NULL, FullPath, "specular", materialIndex);
 }
 
 void Mesh::loadAlbedoTexture(const std::string& dir, const aiMaterial* pMaterial, int materialIndex)
 {
-    m_materials[materialIndex].PBRmaterial.pAlbedo = NULL;
+    m_materials[materialIndex].PBRmaterial.pAlbedo = nullptr;
 
     if (pMaterial->GetTextureCount(aiTextureType_BASE_COLOR) > 0) {
         aiString Path;
@@ -296,29 +824,19 @@ void Mesh::loadAlbedoTexture(const std::string& dir, const aiMaterial* pMaterial
 void Mesh::loadAlbedoTextureEmbedded(const aiTexture* paiTexture, int materialIndex)
 {
     printf("Embeddeded albedo texture type '%s'\n", paiTexture->achFormatHint);
-    m_materials[materialIndex].PBRmaterial.pAlbedo = new Texture(GL_TEXTURE_2D);
-    int buffer_size = paiTexture->mWidth;
-    m_materials[materialIndex].PBRmaterial.pAlbedo->Load(buffer_size, paiTexture->pcData);
+    m_materials[materialIndex].PBRmaterial.pAlbedo = acquireTexture(paiTexture, "", "albedo", materialIndex);
 }
 
 void Mesh::loadAlbedoTextureFromFile(const std::string& dir, const aiString& Path, int materialIndex)
 {
     std::string FullPath = GetFullPath(dir, Path);
 
-    m_materials[materialIndex].PBRmaterial.pAlbedo = new Texture(GL_TEXTURE_2D, FullPath.c_str());
-
-    if (!m_materials[materialIndex].PBRmaterial.pAlbedo->Load()) {
-        printf("Error loading albedo texture '%s'\n", FullPath.c_str());
-        exit(0);
-    }
-    else {
-        printf("Loaded albedo texture '%s'\n", FullPath.c_str());
-    }
+    m_materials[materialIndex].PBRmaterial.pAlbedo = acquireTexture(NULL, FullPath, "albedo", materialIndex);
 }
 
 void Mesh::loadMetalnessTexture(const std::string& dir, const aiMaterial* pMaterial, int materialIndex)
 {
-    m_materials[materialIndex].PBRmaterial.pMetallic = NULL;
+    m_materials[materialIndex].PBRmaterial.pMetallic = nullptr;
 
     int NumTextures = pMaterial->GetTextureCount(aiTextureType_METALNESS);
 
@@ -343,29 +861,19 @@ void Mesh::loadMetalnessTexture(const std::string& dir, const aiMaterial* pMater
 void Mesh::loadMetalnessTextureEmbedded(const aiTexture* paiTexture, int materialIndex)
 {
     printf("Embeddeded metalness texture type '%s'\n", paiTexture->achFormatHint);
-    m_materials[materialIndex].PBRmaterial.pMetallic = new Texture(GL_TEXTURE_2D);
-    int buffer_size = paiTexture->mWidth;
-    m_materials[materialIndex].PBRmaterial.pMetallic->Load(buffer_size, paiTexture->pcData);
+    m_materials[materialIndex].PBRmaterial.pMetallic = acquireTexture(paiTexture, "", "metalness", materialIndex);
 }
 
 void Mesh::loadMetalnessTextureFromFile(const std::string& dir, const aiString& Path, int materialIndex)
 {
     std::string FullPath = GetFullPath(dir, Path);
 
-    m_materials[materialIndex].PBRmaterial.pMetallic = new Texture(GL_TEXTURE_2D, FullPath.c_str());
-
-    if (!m_materials[materialIndex].PBRmaterial.pMetallic->Load()) {
-        printf("Error loading metalness texture '%s'\n", FullPath.c_str());
-        exit(0);
-    }
-    else {
-        printf("Loaded metalness texture '%s'\n", FullPath.c_str());
-    }
+    m_materials[materialIndex].PBRmaterial.pMetallic = acquireTexture(NULL, FullPath, "metalness", materialIndex);
 }
 
 void Mesh::loadRoughnessTexture(const std::string& dir, const aiMaterial* pMaterial, int materialIndex)
 {
-    m_materials[materialIndex].PBRmaterial.pRoughness = NULL;
+    m_materials[materialIndex].PBRmaterial.pRoughness = nullptr;
 
     int NumTextures = pMaterial->GetTextureCount(aiTextureType_DIFFUSE_ROUGHNESS);
 
@@ -390,49 +898,93 @@ void Mesh::loadRoughnessTexture(const std::string& dir, const aiMaterial* pMater
 void Mesh::loadRoughnessTextureEmbedded(const aiTexture* paiTexture, int materialIndex)
 {
     printf("Embeddeded roughness texture type '%s'\n", paiTexture->achFormatHint);
-    m_materials[materialIndex].PBRmaterial.pRoughness = new Texture(GL_TEXTURE_2D);
-    int buffer_size = paiTexture->mWidth;
-    m_materials[materialIndex].PBRmaterial.pRoughness->Load(buffer_size, paiTexture->pcData);
+    m_materials[materialIndex].PBRmaterial.pRoughness = acquireTexture(paiTexture, "", "roughness", materialIndex);
 }
 
 void Mesh::loadRoughnessTextureFromFile(const std::string& dir, const aiString& Path, int materialIndex)
 {
     std::string FullPath = GetFullPath(dir, Path);
 
-    m_materials[materialIndex].PBRmaterial.pRoughness = new Texture(GL_TEXTURE_2D, FullPath.c_str());
+    m_materials[materialIndex].PBRmaterial.pRoughness = acquireTexture(NULL, FullPath, "roughness", materialIndex);
+}
+
+void Mesh::populateBuffers()
+{
+    if (m_vertexFormat == VERTEX_FORMAT_QUANTIZED) {
+        glNamedBufferStorage(m_buffers[VERTEX_BUFFER], m_vertexBufferBytes, m_quantizedVertices.data(), 0);
+        glNamedBufferStorage(m_buffers[INDEX_BUFFER], m_indexBufferBytes, m_packedIndices.data(), 0);
+    } else {
+        glNamedBufferStorage(m_buffers[VERTEX_BUFFER], m_vertexBufferBytes, m_pSourceVertices, 0);
+        glNamedBufferStorage(m_buffers[INDEX_BUFFER], m_indexBufferBytes, m_pSourceIndices, 0);
+    }
+
+    setupVertexFormat();
+}
+
+// Reserves storage for the whole model so sub-meshes can be uploaded as they arrive
+void Mesh::allocateBuffers()
+{
+    glNamedBufferStorage(m_buffers[VERTEX_BUFFER], m_vertexBufferBytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(m_buffers[INDEX_BUFFER], m_indexBufferBytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    setupVertexFormat();
+}
+
+void Mesh::uploadSubMesh(const MeshData& mesh)
+{
+    size_t indexBytes = static_cast<size_t>(mesh.IndexSize) * mesh.getIndexRange();
+
+    if (m_vertexFormat == VERTEX_FORMAT_QUANTIZED) {
+        if (mesh.NumVertices > 0) {
+            glNamedBufferSubData(m_buffers[VERTEX_BUFFER], sizeof(QuantizedVertex) * mesh.BaseVertex, sizeof(QuantizedVertex) * mesh.NumVertices, m_quantizedVertices.data() + mesh.BaseVertex);
+        }
 
-    if (!m_materials[materialIndex].PBRmaterial.pRoughness->Load()) {
-        printf("Error loading roughness texture '%s'\n", FullPath.c_str());
-        exit(0);
+        if (mesh.NumIndices > 0) {
+            glNamedBufferSubData(m_buffers[INDEX_BUFFER], mesh.IndexByteOffset, indexBytes, m_packedIndices.data() + mesh.IndexByteOffset);
+        }
+        return;
     }
-    else {
-        printf("Loaded roughness texture '%s'\n", FullPath.c_str());
+
+    if (mesh.NumVertices > 0) {
+        glNamedBufferSubData(m_buffers[VERTEX_BUFFER], sizeof(Vertex) * mesh.BaseVertex, sizeof(Vertex) * mesh.NumVertices, m_pSourceVertices + mesh.BaseVertex);
+    }
+
+    if (mesh.NumIndices > 0) {
+        glNamedBufferSubData(m_buffers[INDEX_BUFFER], mesh.IndexByteOffset, indexBytes, m_pSourceIndices + mesh.BaseIndex);
     }
 }
 
-void Mesh::populateBuffers()
+void Mesh::setupVertexFormat()
 {
-    glNamedBufferStorage(m_buffers[VERTEX_BUFFER], sizeof(m_vertices[0]) * m_vertices.size(), m_vertices.data(), 0);
-    glNamedBufferStorage(m_buffers[INDEX_BUFFER], sizeof(m_indices[0]) * m_indices.size(), m_indices.data(), 0);
+    glVertexArrayElementBuffer(m_VAO, m_buffers[INDEX_BUFFER]);
+
+    glEnableVertexArrayAttrib(m_VAO, POSITION_LOCATION);
+    glEnableVertexArrayAttrib(m_VAO, TEX_COORD_LOCATION);
+    glEnableVertexArrayAttrib(m_VAO, NORMAL_LOCATION);
+
+    glVertexArrayAttribBinding(m_VAO, POSITION_LOCATION, 0);
+    glVertexArrayAttribBinding(m_VAO, TEX_COORD_LOCATION, 0);
+    glVertexArrayAttribBinding(m_VAO, NORMAL_LOCATION, 0);
+
+    if (m_vertexFormat == VERTEX_FORMAT_QUANTIZED) {
+        glVertexArrayVertexBuffer(m_VAO, 0, m_buffers[VERTEX_BUFFER], 0, sizeof(QuantizedVertex));
+        glVertexArrayAttribFormat(m_VAO, POSITION_LOCATION, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(QuantizedVertex, position));
+        glVertexArrayAttribFormat(m_VAO, TEX_COORD_LOCATION, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(QuantizedVertex, texCoords));
+        glVertexArrayAttribFormat(m_VAO, NORMAL_LOCATION, 2, GL_BYTE, GL_TRUE, offsetof(QuantizedVertex, normal));
+        return;
+    }
 
     glVertexArrayVertexBuffer(m_VAO, 0, m_buffers[VERTEX_BUFFER], 0, sizeof(Vertex));
-    glVertexArrayElementBuffer(m_VAO, m_buffers[INDEX_BUFFER]);
 
     size_t numFloats = 0;
 
-    glEnableVertexArrayAttrib(m_VAO, POSITION_LOCATION);
     glVertexArrayAttribFormat(m_VAO, POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, (GLuint)(numFloats * sizeof(float)));
-    glVertexArrayAttribBinding(m_VAO, POSITION_LOCATION, 0);
     numFloats += 3;
 
-    glEnableVertexArrayAttrib(m_VAO, TEX_COORD_LOCATION);
     glVertexArrayAttribFormat(m_VAO, TEX_COORD_LOCATION, 2, GL_FLOAT, GL_FALSE, (GLuint)(numFloats * sizeof(float)));
-    glVertexArrayAttribBinding(m_VAO, TEX_COORD_LOCATION, 0);
     numFloats += 2;
 
-    glEnableVertexArrayAttrib(m_VAO, NORMAL_LOCATION);
     glVertexArrayAttribFormat(m_VAO, NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, (GLuint)(numFloats * sizeof(float)));
-    glVertexArrayAttribBinding(m_VAO, NORMAL_LOCATION, 0);
 }
 
 void Mesh::loadColors(const aiMaterial* pMaterial, int index)
@@ -465,162 +1017,313 @@ void Mesh::loadColors(const aiMaterial* pMaterial, int index)
     }
 }
 
-bool Mesh::loadMesh(const std::string& filename)
+TriangleView Mesh::getTriangles() const
 {
-    bool result = false;
-    
-    clear();
-    
-    glCreateVertexArrays(1, &m_VAO);
-    glCreateBuffers(ARRAY_SIZE_IN_ELEMENTS(m_buffers), m_buffers);
-    
-    m_pScene = m_importer.ReadFile(filename.c_str(), ASSIMP_LOAD_FLAGS);
+    if (m_vertices.empty() || m_indices.empty()) {
+        return TriangleView();
+    }
 
-    if (m_pScene) {
-        m_globalInverseTransform = m_pScene->mRootNode->mTransformation;
-        m_globalInverseTransform = m_globalInverseTransform.Inverse();
-        result = initScene(m_pScene, filename);
+    return TriangleView(&m_vertices[0].position.x, sizeof(Vertex), m_indices.data(), &m_meshes);
+}
+
+// Called once everything is on the GPU. The Assimp scene is never needed past this point;
+// the vertex/index arrays are kept for getTriangles() unless the load opted out.
+void Mesh::releaseSourceGeometry()
+{
+    m_importer.FreeScene();
+    m_pScene = nullptr;
+
+    if (!m_keepCpuGeometry) {
+        std::vector<Vertex>().swap(m_vertices);
+        std::vector<uint>().swap(m_indices);
+    } else if (m_loadedFromCache && m_pSourceVertices && m_pSourceIndices) {
+        // A warm load streamed straight from the mapping, copy it out before the cache is closed
+        m_vertices.assign(m_pSourceVertices, m_pSourceVertices + m_numVertices);
+        m_indices.assign(m_pSourceIndices, m_pSourceIndices + m_numIndices);
     }
-    else {
-        printf("Error parsing '%s': '%s'\n", filename.c_str(), m_importer.GetErrorString());
+}
+
+bool Mesh::loadMesh(const std::string& filename, const LoadOptions& options)
+{
+    if (options.Async) {
+        return loadMeshAsync(filename, options);
     }
-    
+
+    TRACE_SCOPE("Mesh::loadMesh");
+
+    beginLoad(options);
+
+    bool result = importModel(filename);
+
+    if (result) {
+        populateBuffers();
+
+        for (MeshData& mesh : m_meshes) {
+            mesh.Ready = true;
+        }
+
+        uploadTextures();
+        result = GL_CHECK_ERROR();
+    }
+
+    finishLoad(filename, result);
     return result;
 }
 
-void Mesh::drawTriangles(GLuint wireframeProgram, const glm::mat4& mvp) {
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+bool Mesh::loadMeshAsync(const std::string& filename, const LoadOptions& options)
+{
+    beginLoad(options);
 
-    float normalLength = 0.25f;
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec3> centroids;
-    std::vector<glm::vec3> normalLines;
-
-    for (const auto& tri : m_triangles) {
-        vertices.push_back(tri.v0);
-        vertices.push_back(tri.v1);
-        vertices.push_back(tri.v2);
-        
-        glm::vec3 centroid = (tri.v0 + tri.v1 + tri.v2) / 3.0f;
-        centroids.push_back(centroid);
+    m_loadState = LOAD_IN_PROGRESS;
+    m_loadThread = std::thread([this, filename]() {
+        TRACE_THREAD_NAME("Loader");
+        bool result = importModel(filename);
+
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        m_importResult = result;
+        m_importFinished = true;
+    });
+
+    return true;
+}
+
+bool Mesh::update()
+{
+    if (m_loadState != LOAD_IN_PROGRESS) {
+        return false;
     }
 
-    for (size_t i = 0; i < m_indices.size(); i+=3) {
-        glm::vec3 v0 = glm::vec3(m_vertices[m_indices[i]].position.x, m_vertices[m_indices[i]].position.y, m_vertices[m_indices[i]].position.z);
-        glm::vec3 v1 = glm::vec3(m_vertices[m_indices[i + 1]].position.x, m_vertices[m_indices[i + 1]].position.y, m_vertices[m_indices[i + 1]].position.z);
-        glm::vec3 v2 = glm::vec3(m_vertices[m_indices[i + 2]].position.x, m_vertices[m_indices[i + 2]].position.y, m_vertices[m_indices[i + 2]].position.z);
+    std::vector<uint> readyMeshes;
+    bool layoutReady;
+    bool importFinished;
 
-        glm::vec3 n0 = glm::vec3(m_vertices[m_indices[i]].normal.x, m_vertices[m_indices[i]].normal.y, m_vertices[m_indices[i]].normal.z);
-        glm::vec3 n1 = glm::vec3(m_vertices[m_indices[i + 1]].normal.x, m_vertices[m_indices[i + 1]].normal.y, m_vertices[m_indices[i + 1]].normal.z);
-        glm::vec3 n2 = glm::vec3(m_vertices[m_indices[i + 2]].normal.x, m_vertices[m_indices[i + 2]].normal.y, m_vertices[m_indices[i + 2]].normal.z);
+    {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        layoutReady = m_layoutReady;
+        importFinished = m_importFinished;
+        readyMeshes.swap(m_readyMeshes);
+    }
 
-        //Average normal
-        glm::vec3 n = (n0 + n1 + n2) / 3.0f;
-        glm::vec3 centroid = (v0 + v1 + v2) / 3.0f;
+    bool uploaded = false;
 
-        normalLines.push_back(centroid);
-        normalLines.push_back(centroid + n * normalLength);
+    if (layoutReady && !m_buffersAllocated) {
+        allocateBuffers();
+        m_buffersAllocated = true;
+        uploaded = true;
     }
 
-    // Bind VAO
-    glBindVertexArray(VAO);
+    for (uint meshIndex : readyMeshes) {
+        uploadSubMesh(m_meshes[meshIndex]);
+        m_meshes[meshIndex].Ready = true;
+        m_numUploadedMeshes++;
+        uploaded = true;
+    }
 
-    // Bind and fill VBO with vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+    // Checked right after this call's uploads, the frames in between issue their own GL calls
+    if (uploaded && !GL_CHECK_ERROR()) {
+        m_uploadFailed = true;
+    }
 
-    // Enable and set vertex attribute pointers
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
+    if (importFinished) {
+        m_loadThread.join();
 
-    // Use wireframe shader program
-    glUseProgram(wireframeProgram);
+        bool result = m_importResult && !m_uploadFailed;
+        if (result) {
+            uploadTextures();
+            result = GL_CHECK_ERROR();
+        }
+
+        finishLoad(m_loadFileName, result);
+    }
+
+    return true;
+}
+
+float Mesh::getLoadProgress() const
+{
+    if (m_loadState != LOAD_IN_PROGRESS) {
+        return m_loadState == LOAD_DONE ? 1.0f : 0.0f;
+    }
 
-    // Set uniform for wireframe color
-    GLuint colorLoc = glGetUniformLocation(wireframeProgram, "wireframeColor");
-    glUniform3f(colorLoc, 1.0f, 0.0f, 0.0f); // Red color
+    // The first tenth covers the Assimp import itself
+    if (!m_buffersAllocated || m_meshes.empty()) {
+        return 0.1f * m_pImportProgress->getProgress();
+    }
 
-    // Set uniform for MVP matrix
-    GLuint mvpLoc = glGetUniformLocation(wireframeProgram, "mvp");
-    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
+    return 0.1f + 0.9f * static_cast<float>(m_numUploadedMeshes) / m_meshes.size();
+}
 
-    // Render in wireframe mode
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size());
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+void Mesh::beginLoad(const LoadOptions& options)
+{
+    clear();
 
-    GLuint centroidVBO;
-    glGenBuffers(1, &centroidVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, centroidVBO);
-    glBufferData(GL_ARRAY_BUFFER, centroids.size() * sizeof(glm::vec3), centroids.data(), GL_STATIC_DRAW);
+    // Drop errors left behind by earlier GL calls so the load only reports its own
+    while (glGetError() != GL_NO_ERROR) {}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
+    glCreateVertexArrays(1, &m_VAO);
+    glCreateBuffers(ARRAY_SIZE_IN_ELEMENTS(m_buffers), m_buffers);
 
-    // Set uniform for centroid color (green)
-    glUniform3f(colorLoc, 0.0f, 1.0f, 0.0f);
+    m_loadStart = std::chrono::steady_clock::now();
+    m_vertexFormat = options.VertexFormat;
+    m_optimizeMeshes = options.Optimize;
+    m_generateLods = options.GenerateLods;
+
+#ifndef GFX_USE_MESHOPTIMIZER
+    // Both stages are built on meshoptimizer, which run.sh only enables when it is installed
+    if (m_optimizeMeshes || m_generateLods) {
+        printf(RED_TEXT "Built without meshoptimizer, mesh optimization and LOD generation are disabled" RESET_TEXT "\n");
+        m_optimizeMeshes = false;
+        m_generateLods = false;
+    }
+#endif
+    m_keepCpuGeometry = options.KeepCpuGeometry;
+    m_importProfile = options.ImportProfile;
+    m_timeImportSteps = options.TimeImportSteps;
+    m_importStepTimings.clear();
+    m_pImportProgress->reset();
+    m_optimizeStats = OptimizeStats();
+    m_loadedFromCache = false;
+    m_layoutReady = false;
+    m_importFinished = false;
+    m_importResult = false;
+    m_buffersAllocated = false;
+    m_uploadFailed = false;
+    m_indirectBuffersAllocated = false;
+    m_transformNodes.clear();
+    m_transformNodeOfMesh.clear();
+    m_numUploadedMeshes = 0;
+    m_readyMeshes.clear();
+}
 
-    // Render points
-    glPointSize(3.0f); // Adjust point size as needed
-    glDrawArrays(GL_POINTS, 0, centroids.size());
+// CPU side of a load: never touches GL state, so it can run on the loader thread
+bool Mesh::importModel(const std::string& filename)
+{
+    TRACE_SCOPE("Mesh::importModel");
 
-    // Render normals as lines
-    GLuint normalVBO;
-    glGenBuffers(1, &normalVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, normalVBO);
-    glBufferData(GL_ARRAY_BUFFER, normalLines.size() * sizeof(glm::vec3), normalLines.data(), GL_STATIC_DRAW);
+    m_loadFileName = filename;
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
+    MeshCache::SourceInfo source;
+    std::string cachePath = MeshCache::getCachePath(filename);
+    bool hasSource = MeshCache::describeSource(filename, source);
 
-    // Set uniform for normal color (cyan)
-    glUniform3f(colorLoc, 0.0f, 1.0f, 1.0f);
+    unsigned int importFlags = getImportFlags();
 
-    // Render lines
-    glDrawArrays(GL_LINES, 0, normalLines.size());
+    if (hasSource && m_cache.open(cachePath, filename, source, importFlags, getPipelineFlags(), sizeof(Vertex))) {
+        m_pScene = nullptr;
+        m_loadedFromCache = true;
+        return initFromCache(m_cache);
+    }
 
-    // Cleanup
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    glDeleteBuffers(1, &VBO);
-    glDeleteVertexArrays(1, &VAO);
+    if (m_timeImportSteps) {
+        m_pScene = ImportProfile::readFileByStep(m_importer, filename, importFlags, m_importStepTimings);
+    } else {
+        m_pScene = m_importer.ReadFile(filename.c_str(), importFlags);
+    }
 
-    glUseProgram(0); // Reset shader program
+    if (!m_pScene) {
+        printf("Error parsing '%s': '%s'\n", filename.c_str(), m_importer.GetErrorString());
+        return false;
+    }
+
+    m_globalInverseTransform = m_pScene->mRootNode->mTransformation;
+    m_globalInverseTransform = m_globalInverseTransform.Inverse();
+
+    if (!initScene(m_pScene, filename)) {
+        return false;
+    }
+
+    // A cold load can afford the content hash that lets a later open survive a touched source
+    if (hasSource && (source.Hash != 0 || MeshCache::hashSource(filename, source))) {
+        MeshCache::write(cachePath, source, importFlags, getPipelineFlags(), m_meshes, m_materials,
+                         m_vertices.data(), static_cast<uint32_t>(m_vertices.size()), sizeof(Vertex),
+                         m_indices.data(), static_cast<uint32_t>(m_indices.size()));
+    }
+
+    return true;
 }
 
-void Mesh::extractTrianglesFromScene() {
-    for (unsigned int meshIndex = 0; meshIndex < m_pScene->mNumMeshes; ++meshIndex) {
-        const aiMesh* mesh = m_pScene->mMeshes[meshIndex];
+void Mesh::finishLoad(const std::string& filename, bool result)
+{
+    releaseSourceGeometry();
+
+    // Everything has been copied into GL buffers, the mapping is no longer needed
+    m_cache.close();
+    m_pSourceVertices = m_vertices.data();
+    m_pSourceIndices = m_indices.data();
+
+    // The packed copies only exist to feed the GPU
+    std::vector<QuantizedVertex>().swap(m_quantizedVertices);
+    std::vector<unsigned char>().swap(m_packedIndices);
+
+    m_loadState = result ? LOAD_DONE : LOAD_FAILED;
+
+    if (result) {
+        buildTransformHierarchy();
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_loadStart).count();
+
+    if (m_loadedFromCache) {
+        printf("Loaded '%s' from cache (warm) in %.2f ms\n", filename.c_str(), ms);
+    } else {
+        printf("Loaded '%s' through Assimp (cold, %s) in %.2f ms\n", filename.c_str(), ImportProfile::getName(m_importProfile), ms);
+    }
+
+    if (!m_importStepTimings.empty()) {
+        ImportProfile::printTimings(m_importStepTimings);
+    }
 
-        // Extract vertex positions
-        std::vector<glm::vec3> vertices;
-        vertices.reserve(mesh->mNumVertices);
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-            const aiVector3D& pos = mesh->mVertices[i];
-            vertices.emplace_back(pos.x, pos.y, pos.z);
+    if (result) {
+        size_t numTriangles = 0;
+        for (const MeshData& mesh : m_meshes) {
+            numTriangles += mesh.NumIndices / 3;
         }
 
-        // Extract triangles from faces
-        for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-            const aiFace& face = mesh->mFaces[i];
+        size_t cpuBytes = sizeof(Vertex) * m_vertices.capacity() + sizeof(uint) * m_indices.capacity();
+        printf("Num triangles: %zu, CPU geometry %s (%.2f MB)\n", numTriangles,
+               m_keepCpuGeometry ? "kept" : "released", cpuBytes / (1024.0 * 1024.0));
+        printVertexFormatStats();
+
+        // Cached geometry was optimized when the cache was written
+        if (m_optimizeMeshes && !m_loadedFromCache) {
+            printOptimizeStats();
+        }
+    }
+}
 
-            // Assimp guarantees all faces are triangles with the default settings
-            if (face.mNumIndices == 3) {
-                glm::vec3 v0 = vertices[face.mIndices[0]];
-                glm::vec3 v1 = vertices[face.mIndices[1]];
-                glm::vec3 v2 = vertices[face.mIndices[2]];
+// Queues the model's triangles as a red wireframe, their centroids as green points and the
+// averaged corner normals as cyan lines, all moved into world space by model.
+void Mesh::drawTriangles(DebugDraw& debugDraw, const glm::mat4& model) {
+    float normalLength = 0.25f;
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
 
-                m_triangles.push_back({v0, v1, v2});
+    TriangleView triangles = getTriangles();
+
+    for (size_t meshIndex = 0; meshIndex < triangles.getNumMeshes(); meshIndex++) {
+        for (uint triangle = 0; triangle < triangles.getNumTriangles(meshIndex); triangle++) {
+            uint corners[3];
+            triangles.getVertexIndices(meshIndex, triangle, corners);
+
+            glm::vec3 v0 = glm::vec3(model * glm::vec4(triangles.getPosition(corners[0]), 1.0f));
+            glm::vec3 v1 = glm::vec3(model * glm::vec4(triangles.getPosition(corners[1]), 1.0f));
+            glm::vec3 v2 = glm::vec3(model * glm::vec4(triangles.getPosition(corners[2]), 1.0f));
+            glm::vec3 centroid = (v0 + v1 + v2) / 3.0f;
+
+            //Average normal
+            glm::vec3 n(0.0f);
+            for (uint corner : corners) {
+                const Vector3f& normal = m_vertices[corner].normal;
+                n += glm::vec3(normal.x, normal.y, normal.z) / 3.0f;
             }
+            n = normalMatrix * n;
+
+            debugDraw.addTriangle(v0, v1, v2, glm::vec3(1.0f, 0.0f, 0.0f)); // Red color
+            debugDraw.addPoint(centroid, glm::vec3(0.0f, 1.0f, 0.0f));
+            debugDraw.addLine(centroid, centroid + n * normalLength, glm::vec3(0.0f, 1.0f, 1.0f));
         }
     }
-    std::cout << "Num triangles: " << m_triangles.size() << std::endl;
 }
 
-float angle = 0;
-
 // glm::mat4 Mesh::computeTransform(const MeshData& mesh)
 // {
 //     glm::mat4 glmTransform = glm::transpose(glm::make_mat4(&mesh.Transform.a1));
@@ -634,6 +1337,8 @@ float angle = 0;
 //     return glmTransform;
 // }
 
+// Reference implementation of the world transform, walking up the parent chain. render() uses the
+// flattened hierarchy instead and only falls back to this while an asynchronous load is in flight.
 glm::mat4 Mesh::computeTransform(const MeshData& mesh)
 {
     // Base case: no parent, return identity matrix
@@ -646,7 +1351,7 @@ glm::mat4 Mesh::computeTransform(const MeshData& mesh)
     if (mesh.containsInAncestry("A0"))
     {
         glm::vec3 rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f); // Example: Y-axis
-        float angleInRadians = glm::radians(-angle);
+        float angleInRadians = glm::radians(-m_animationAngle);
         localTransform = glm::rotate(localTransform, angleInRadians, rotationAxis);
         glm::mat4 parentTransform = glm::inverse(mesh.Parent->getTransform()) * computeTransform(*mesh.Parent);
         localTransform = parentTransform * localTransform;
@@ -655,52 +1360,456 @@ glm::mat4 Mesh::computeTransform(const MeshData& mesh)
     return localTransform;
 }
 
-void Mesh::render(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection, bool toggle)
+void Mesh::render(LightingTechnique& technique, const glm::mat4& view, const glm::mat4& projection, bool toggle)
 {
-    glUseProgram(shaderProgram);
-
-    // Set the view and projection matrices
-    GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLuint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    TRACE_SCOPE("Mesh::render");
+
+    // View, projection and lighting come from the FrameData uniform block. A program that
+    // failed to link draws nothing, and the stats say so
+    if (!technique.Enable()) {
+        m_lodDrawCounts.fill(0);
+        m_numDrawnMeshes = 0;
+        m_numCulledMeshes = 0;
+        m_numIndicesDrawn = 0;
+        return;
+    }
 
     glBindVertexArray(m_VAO);
 
-    // Map to store computed transformations
-    std::unordered_map<std::string, glm::mat4> meshTransforms;
+    // Pixels covered by one world unit at distance one, used to project LOD errors
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float pixelsPerUnit = projection[1][1] * viewport[3] * 0.5f;
+    glm::vec3 cameraPos = glm::vec3(glm::inverse(view)[3]);
+    m_lodDrawCounts.fill(0);
+
+    FrustumCulling frustum(Matrix4f(projection * view));
+    m_numDrawnMeshes = 0;
+    m_numCulledMeshes = 0;
+    m_numIndicesDrawn = 0;
+
+    updateTransforms();
 
     for (unsigned int meshIndex = 0; meshIndex < m_meshes.size(); meshIndex++) {
         MeshData& mesh = m_meshes[meshIndex];
 
-        // Compute the transformation for this mesh
-        glm::mat4 transform = computeTransform(mesh);
+        // Sub-meshes still in flight from the loader thread are skipped
+        if (!mesh.Ready) {
+            continue;
+        }
+
+        // World transform from the hierarchy pass
+        glm::mat4 transform = getWorldTransform(meshIndex);
+
+        if (cullSubMesh(mesh, transform, frustum)) {
+            continue;
+        }
 
-        // Set the model matrix
-        GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(transform));
+        // Set the model matrix and its normal matrix, computed once per mesh instead of per vertex
+        technique.SetModel(transform);
+        technique.SetNormalMatrix(getNormalMatrix(meshIndex, transform));
 
         // Set the object color
-        Material material = m_materials[mesh.MaterialIndex];
-        glm::vec3 objectColor = material.getDiffuseColor();
+        technique.SetObjectColor(getObjectColor(mesh, toggle));
 
-        if (mesh.Name.find("Lamp") != std::string::npos) {
-            if (toggle) 
-                objectColor = glm::vec3(1.0f, 0.10f, 0.10f);
+        // Quantized positions are stored relative to the sub-mesh bounds
+        if (m_vertexFormat == VERTEX_FORMAT_QUANTIZED) {
+            technique.SetQuantization(mesh.AABBMin, mesh.AABBMax - mesh.AABBMin);
         }
 
-        glUniform3fv(glGetUniformLocation(shaderProgram, "objectColor"), 1, glm::value_ptr(objectColor));
+        uint level = selectLod(mesh, transform, cameraPos, pixelsPerUnit);
+        uint numIndices;
+        size_t indexByteOffset;
+        getDrawRange(mesh, level, numIndices, indexByteOffset);
+
+        m_lodDrawCounts[level]++;
+        m_numIndicesDrawn += numIndices;
 
         // Draw the mesh
         glDrawElementsBaseVertex(GL_TRIANGLES,
-                                 mesh.NumIndices,
-                                 GL_UNSIGNED_INT,
-                                 (void*)(sizeof(unsigned int) * mesh.BaseIndex),
+                                 numIndices,
+                                 mesh.IndexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+                                 (void*)indexByteOffset,
                                  mesh.BaseVertex);
     }
 
     glBindVertexArray(0);
     glUseProgram(0);
+}
+
+void Mesh::renderIndirect(LightingTechnique& technique, const glm::mat4& view, const glm::mat4& projection, bool toggle)
+{
+    TRACE_SCOPE("Mesh::renderIndirect");
+
+    // The buffers are sized by the sub-mesh count, which is only final once the layout is published
+    if (m_meshes.empty() || (m_loadState == LOAD_IN_PROGRESS && !m_buffersAllocated)) {
+        return;
+    }
+
+    if (!technique.Enable()) {
+        m_lodDrawCounts.fill(0);
+        m_numDrawnMeshes = 0;
+        m_numCulledMeshes = 0;
+        m_numIndicesDrawn = 0;
+        return;
+    }
+
+    if (!m_indirectBuffersAllocated) {
+        allocateIndirectBuffers();
+        m_indirectBuffersAllocated = true;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float pixelsPerUnit = projection[1][1] * viewport[3] * 0.5f;
+    glm::vec3 cameraPos = glm::vec3(glm::inverse(view)[3]);
+    m_lodDrawCounts.fill(0);
+
+    FrustumCulling frustum(Matrix4f(projection * view));
+    m_numDrawnMeshes = 0;
+    m_numCulledMeshes = 0;
+    m_numIndicesDrawn = 0;
+
+    updateTransforms();
+
+    m_drawCommands.clear();
+    m_drawCommands16.clear();
 
-    angle += 0.05f; // Increment angle for animation
-}
\ No newline at end of file
+    for (unsigned int meshIndex = 0; meshIndex < m_meshes.size(); meshIndex++) {
+        MeshData& mesh = m_meshes[meshIndex];
+
+        if (!mesh.Ready) {
+            continue;
+        }
+
+        glm::mat4 transform = getWorldTransform(meshIndex);
+
+        if (cullSubMesh(mesh, transform, frustum)) {
+            continue;
+        }
+
+        DrawData& drawData = m_drawData[meshIndex];
+        drawData.Model = transform;
+        drawData.NormalMatrix = glm::mat4(getNormalMatrix(meshIndex, transform));
+        drawData.Color = glm::vec4(getObjectColor(mesh, toggle), 1.0f);
+        drawData.QuantMin = glm::vec4(mesh.AABBMin, 0.0f);
+        drawData.QuantExtent = glm::vec4(mesh.AABBMax - mesh.AABBMin, 0.0f);
+
+        uint level = selectLod(mesh, transform, cameraPos, pixelsPerUnit);
+        uint numIndices;
+        size_t indexByteOffset;
+        getDrawRange(mesh, level, numIndices, indexByteOffset);
+
+        m_lodDrawCounts[level]++;
+        m_numIndicesDrawn += numIndices;
+
+        // baseInstance carries the sub-mesh index to the shader through DRAW_ID_BUFFER
+        DrawElementsIndirectCommand command;
+        command.Count = numIndices;
+        command.InstanceCount = 1;
+        command.FirstIndex = static_cast<uint>(indexByteOffset / mesh.IndexSize);
+        command.BaseVertex = static_cast<int>(mesh.BaseVertex);
+        command.BaseInstance = meshIndex;
+
+        if (mesh.IndexSize == sizeof(uint16_t)) {
+            m_drawCommands16.push_back(command);
+        } else {
+            m_drawCommands.push_back(command);
+        }
+    }
+
+    GLsizei numCommands32 = static_cast<GLsizei>(m_drawCommands.size());
+    GLsizei numCommands16 = static_cast<GLsizei>(m_drawCommands16.size());
+    m_drawCommands.insert(m_drawCommands.end(), m_drawCommands16.begin(), m_drawCommands16.end());
+
+    glNamedBufferSubData(m_buffers[DRAW_DATA_BUFFER], 0, sizeof(DrawData) * m_drawData.size(), m_drawData.data());
+    glNamedBufferSubData(m_buffers[DRAW_COMMAND_BUFFER], 0, sizeof(DrawElementsIndirectCommand) * m_drawCommands.size(), m_drawCommands.data());
+
+    glBindVertexArray(m_VAO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, m_buffers[DRAW_DATA_BUFFER]);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_buffers[DRAW_COMMAND_BUFFER]);
+
+    if (numCommands32 > 0) {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, numCommands32, 0);
+    }
+
+    if (numCommands16 > 0) {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT,
+                                    (void*)(sizeof(DrawElementsIndirectCommand) * numCommands32), numCommands16, 0);
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+// Sizes the indirect buffers for every sub-mesh and adds the instanced draw ID attribute to m_VAO
+void Mesh::allocateIndirectBuffers()
+{
+    uint numMeshes = static_cast<uint>(m_meshes.size());
+
+    m_drawData.assign(numMeshes, DrawData());
+    m_drawCommands.reserve(numMeshes);
+    m_drawCommands16.reserve(numMeshes);
+
+    std::vector<uint> drawIds(numMeshes);
+    for (uint i = 0; i < numMeshes; i++) {
+        drawIds[i] = i;
+    }
+
+    glNamedBufferStorage(m_buffers[DRAW_COMMAND_BUFFER], sizeof(DrawElementsIndirectCommand) * numMeshes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(m_buffers[DRAW_DATA_BUFFER], sizeof(DrawData) * numMeshes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(m_buffers[DRAW_ID_BUFFER], sizeof(uint) * numMeshes, drawIds.data(), 0);
+
+    // One value per instance, starting at the command's baseInstance
+    glVertexArrayVertexBuffer(m_VAO, 1, m_buffers[DRAW_ID_BUFFER], 0, sizeof(uint));
+    glVertexArrayBindingDivisor(m_VAO, 1, 1);
+    glEnableVertexArrayAttrib(m_VAO, DRAW_ID_LOCATION);
+    glVertexArrayAttribIFormat(m_VAO, DRAW_ID_LOCATION, 1, GL_UNSIGNED_INT, 0);
+    glVertexArrayAttribBinding(m_VAO, DRAW_ID_LOCATION, 1);
+}
+
+// Flattens the MeshData parent pointers into m_transformNodes, breadth first from the roots so
+// that parents always precede their children. Runs once per load, after the hierarchy is final.
+void Mesh::buildTransformHierarchy()
+{
+    m_transformNodes.clear();
+    m_transformNodes.reserve(m_meshes.size());
+    m_transformNodeOfMesh.assign(m_meshes.size(), 0);
+
+    for (uint meshIndex = 0; meshIndex < m_meshes.size(); meshIndex++) {
+        if (m_meshes[meshIndex].Parent == nullptr) {
+            TransformNode node;
+            node.MeshIndex = meshIndex;
+            m_transformNodes.push_back(node);
+        }
+    }
+
+    for (size_t i = 0; i < m_transformNodes.size(); i++) {
+        const MeshData& mesh = m_meshes[m_transformNodes[i].MeshIndex];
+
+        // Resolved here once instead of a containsInAncestry("A0") walk per mesh and frame
+        bool animated = m_transformNodes[i].Animated || mesh.Name.find("A0") != std::string::npos;
+
+        for (const MeshData* pChild : mesh.Children) {
+            TransformNode child;
+            child.MeshIndex = static_cast<uint>(pChild - m_meshes.data());
+            child.Parent = static_cast<int>(i);
+            child.Animated = animated;
+            child.InvParentBind = glm::inverse(mesh.getTransform());
+            m_transformNodes.push_back(child);
+        }
+    }
+
+    glm::mat4 spin = getAnimationSpin();
+
+    for (size_t i = 0; i < m_transformNodes.size(); i++) {
+        TransformNode& node = m_transformNodes[i];
+        node.Bind = m_meshes[node.MeshIndex].getTransform();
+        node.Local = node.Animated ? node.Bind * spin : node.Bind;
+        m_transformNodeOfMesh[node.MeshIndex] = static_cast<uint>(i);
+    }
+}
+
+glm::mat4 Mesh::getAnimationSpin() const
+{
+    return glm::rotate(glm::mat4(1.0f), glm::radians(-m_animationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+void Mesh::setAnimationAngle(float degrees)
+{
+    if (degrees == m_animationAngle) {
+        return;
+    }
+
+    m_animationAngle = degrees;
+
+    // Before the hierarchy is flattened computeTransform() reads the angle directly
+    glm::mat4 spin = getAnimationSpin();
+
+    for (const TransformNode& node : m_transformNodes) {
+        if (node.Animated) {
+            setLocalTransform(node.MeshIndex, node.Bind * spin);
+        }
+    }
+}
+
+void Mesh::setLocalTransform(uint meshIndex, const glm::mat4& transform)
+{
+    if (m_transformNodes.empty()) {
+        return;
+    }
+
+    TransformNode& node = m_transformNodes[m_transformNodeOfMesh[meshIndex]];
+    node.Local = transform;
+    node.Dirty = true;
+}
+
+// Recomputes world transforms in one forward pass. A node is visited only when its own local
+// transform is dirty or, for animated nodes, when its parent's world changed. Animated nodes
+// follow computeTransform(): World = inverse(parent Bind) * parent World * Local, Local = Bind * spin.
+void Mesh::updateTransforms()
+{
+    if (m_transformNodes.empty()) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    m_numTransformsUpdated = 0;
+
+    for (TransformNode& node : m_transformNodes) {
+        const TransformNode* pParent = node.Parent >= 0 ? &m_transformNodes[node.Parent] : nullptr;
+
+        node.Changed = node.Dirty || (node.Animated && pParent->Changed);
+        node.Dirty = false;
+
+        if (!node.Changed) {
+            continue;
+        }
+
+        node.World = node.Animated ? node.InvParentBind * pParent->World * node.Local : node.Local;
+        node.Normal = glm::transpose(glm::inverse(glm::mat3(node.World)));
+        m_numTransformsUpdated++;
+    }
+
+    m_transformUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+glm::mat4 Mesh::getWorldTransform(uint meshIndex)
+{
+    // The hierarchy is only flattened once the load finished, streamed sub-meshes walk their parents
+    if (m_transformNodes.empty()) {
+        return computeTransform(m_meshes[meshIndex]);
+    }
+
+    return m_transformNodes[m_transformNodeOfMesh[meshIndex]].World;
+}
+
+glm::mat3 Mesh::getNormalMatrix(uint meshIndex, const glm::mat4& transform) const
+{
+    if (m_transformNodes.empty()) {
+        return glm::transpose(glm::inverse(glm::mat3(transform)));
+    }
+
+    return m_transformNodes[m_transformNodeOfMesh[meshIndex]].Normal;
+}
+
+// Moves the mesh-space bounds into world space and tests them against the view frustum.
+// Returns true, and counts the sub-mesh as culled, when it can be skipped.
+bool Mesh::cullSubMesh(MeshData& mesh, const glm::mat4& transform, const FrustumCulling& frustum)
+{
+    // Transformed box of the bounds: center moves with the matrix, half extents through its absolute values
+    glm::vec3 center = glm::vec3(transform * glm::vec4((mesh.AABBMin + mesh.AABBMax) * 0.5f, 1.0f));
+    glm::vec3 halfExtent = (mesh.AABBMax - mesh.AABBMin) * 0.5f;
+    glm::vec3 worldHalfExtent = glm::abs(glm::vec3(transform[0])) * halfExtent.x +
+                                glm::abs(glm::vec3(transform[1])) * halfExtent.y +
+                                glm::abs(glm::vec3(transform[2])) * halfExtent.z;
+
+    mesh.WorldAABBMin = center - worldHalfExtent;
+    mesh.WorldAABBMax = center + worldHalfExtent;
+
+    if (m_frustumCulling && !frustum.IsAABBInsideViewFrustum(Vector3f(mesh.WorldAABBMin), Vector3f(mesh.WorldAABBMax))) {
+        m_numCulledMeshes++;
+        return true;
+    }
+
+    m_numDrawnMeshes++;
+    return false;
+}
+
+// Index range of a sub-mesh at the given level, 0 being full resolution
+void Mesh::getDrawRange(const MeshData& mesh, uint level, uint& numIndices, size_t& indexByteOffset) const
+{
+    numIndices = mesh.NumIndices;
+    indexByteOffset = mesh.IndexByteOffset;
+
+    if (level > 0) {
+        const MeshData::Lod& lod = mesh.Lods[level - 1];
+        numIndices = lod.NumIndices;
+        indexByteOffset += static_cast<size_t>(lod.BaseIndex - mesh.BaseIndex) * mesh.IndexSize;
+    }
+}
+
+glm::vec3 Mesh::getObjectColor(const MeshData& mesh, bool toggle) const
+{
+    const Material& material = m_materials[mesh.MaterialIndex];
+    glm::vec3 objectColor = material.getDiffuseColor();
+
+    if (mesh.Name.find("Lamp") != std::string::npos) {
+        if (toggle) 
+            objectColor = glm::vec3(1.0f, 0.10f, 0.10f);
+    }
+
+    return objectColor;
+}
+
+// Builds synthetic scenes of increasing size (4-ary trees, one mesh per node) and times
+// the hierarchy construction. A flat time per node means the build scales linearly.
+void Mesh::benchmarkHierarchy(unsigned int maxNodes)
+{
+    const unsigned int branching = 4;
+
+    printf("Hierarchy build benchmark (%u-ary tree)\n", branching);
+    printf("%10s %12s %12s\n", "nodes", "total ms", "ns/node");
+
+    std::vector<unsigned int> sizes;
+    for (unsigned int numNodes = 1000; numNodes < maxNodes; numNodes *= 2) {
+        sizes.push_back(numNodes);
+    }
+    sizes.push_back(maxNodes);
+
+    for (unsigned int numNodes : sizes) {
+        aiScene* pScene = new aiScene();
+        pScene->mNumMeshes = numNodes;
+        pScene->mMeshes = new aiMesh*[numNodes];
+
+        std::vector<aiNode*> nodes(numNodes);
+        std::vector<std::vector<aiNode*>> children(numNodes);
+
+        for (unsigned int i = 0; i < numNodes; i++) {
+            std::string name = "node_" + std::to_string(i);
+
+            pScene->mMeshes[i] = new aiMesh();
+            pScene->mMeshes[i]->mName = aiString(name);
+
+            nodes[i] = new aiNode(name);
+            nodes[i]->mNumMeshes = 1;
+            nodes[i]->mMeshes = new unsigned int[1] { i };
+
+            if (i > 0) {
+                unsigned int parent = (i - 1) / branching;
+                nodes[i]->mParent = nodes[parent];
+                children[parent].push_back(nodes[i]);
+            }
+        }
+
+        for (unsigned int i = 0; i < numNodes; i++) {
+            if (!children[i].empty()) {
+                nodes[i]->mNumChildren = static_cast<unsigned int>(children[i].size());
+                nodes[i]->mChildren = new aiNode*[children[i].size()];
+                std::copy(children[i].begin(), children[i].end(), nodes[i]->mChildren);
+            }
+        }
+
+        pScene->mRootNode = nodes[0];
+
+        Mesh mesh;
+        mesh.m_printHierarchy = false;
+        mesh.m_meshes.resize(numNodes);
+
+        unsigned int numVertices = 0;
+        unsigned int numIndices = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        mesh.countVerticesAndIndices(pScene->mRootNode, pScene, numVertices, numIndices, aiMatrix4x4());
+        mesh.buildNameIndex();
+        mesh.processNode(pScene->mRootNode, pScene);
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printf("%10u %12.3f %12.1f\n", numNodes, ms, ms * 1e6 / numNodes);
+
+        delete pScene;
+    }
+}
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "meshCache.hpp"
+
+static size_t alignTo(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+MeshCache::MeshCache()
+{
+}
+
+MeshCache::~MeshCache()
+{
+    close();
+}
+
+std::string MeshCache::getCachePath(const std::string& sourceFile)
+{
+    std::filesystem::path source(sourceFile);
+    std::string absolute = std::filesystem::absolute(source).string();
+    uint64_t pathHash = utils::hash::fnv1a64(absolute.data(), absolute.size());
+
+    return utils::disk::getCurrentDirectory() + "/cache/" + source.stem().string() + "-" + utils::hash::toHex(pathHash) + ".gfxmesh";
+}
+
+bool MeshCache::describeSource(const std::string& sourceFile, SourceInfo& info)
+{
+    struct stat st;
+    if (stat(sourceFile.c_str(), &st) != 0) {
+        return false;
+    }
+
+    info.Size = static_cast<uint64_t>(st.st_size);
+    info.MTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    info.Hash = 0;
+
+    return true;
+}
+
+bool MeshCache::hashSource(const std::string& sourceFile, SourceInfo& info)
+{
+    std::string contents;
+    if (!utils::disk::readBinaryFile(sourceFile, contents)) {
+        return false;
+    }
+
+    info.Hash = utils::hash::fnv1a64(contents.data(), contents.size());
+    return true;
+}
+
+bool MeshCache::write(const std::string& cachePath, const SourceInfo& source, uint32_t loadFlags, uint32_t pipelineFlags,
+                      const std::vector<MeshData>& meshes, const std::vector<Material>& materials,
+                      const void* pVertices, uint32_t numVertices, uint32_t vertexStride,
+                      const uint32_t* pIndices, uint32_t numIndices)
+{
+    std::vector<MeshRecord> meshRecords(meshes.size());
+    std::string names;
+
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const MeshData& mesh = meshes[i];
+        MeshRecord& record = meshRecords[i];
+
+        record.NameOffset = static_cast<uint32_t>(names.size());
+        record.NameLength = static_cast<uint32_t>(mesh.Name.size());
+        record.Parent = mesh.Parent ? static_cast<int32_t>(mesh.Parent - meshes.data()) : -1;
+        record.NumIndices = mesh.NumIndices;
+        record.NumVertices = mesh.NumVertices;
+        record.BaseVertex = mesh.BaseVertex;
+        record.BaseIndex = mesh.BaseIndex;
+        record.MaterialIndex = mesh.MaterialIndex;
+        record.LodIndexCapacity = mesh.LodIndexCapacity;
+        record.NumLods = static_cast<uint32_t>(std::min<size_t>(mesh.Lods.size(), MAX_LODS));
+
+        for (uint32_t level = 0; level < record.NumLods; level++) {
+            record.LodBaseIndex[level] = mesh.Lods[level].BaseIndex;
+            record.LodNumIndices[level] = mesh.Lods[level].NumIndices;
+            record.LodError[level] = mesh.Lods[level].Error;
+        }
+
+        memcpy(record.Transform, &mesh.Transform.a1, sizeof(record.Transform));
+
+        names += mesh.Name;
+    }
+
+    std::vector<MaterialRecord> materialRecords(materials.size());
+
+    for (size_t i = 0; i < materials.size(); i++) {
+        const Material& material = materials[i];
+        MaterialRecord& record = materialRecords[i];
+
+        memcpy(record.Ambient, &material.AmbientColor.x, sizeof(record.Ambient));
+        memcpy(record.Diffuse, &material.DiffuseColor.x, sizeof(record.Diffuse));
+        memcpy(record.Specular, &material.SpecularColor.x, sizeof(record.Specular));
+    }
+
+    Header header = {};
+    header.Magic = MAGIC;
+    header.Version = VERSION;
+    header.LoadFlags = loadFlags;
+    header.PipelineFlags = pipelineFlags;
+    header.VertexStride = vertexStride;
+    header.SourceSize = source.Size;
+    header.SourceMTime = source.MTime;
+    header.SourceHash = source.Hash;
+    header.NumMeshes = static_cast<uint32_t>(meshRecords.size());
+    header.NumMaterials = static_cast<uint32_t>(materialRecords.size());
+    header.NumVertices = numVertices;
+    header.NumIndices = numIndices;
+    header.NamesOffset = sizeof(Header) + sizeof(MeshRecord) * meshRecords.size() + sizeof(MaterialRecord) * materialRecords.size();
+    header.VerticesOffset = alignTo(header.NamesOffset + names.size(), 16);
+    header.IndicesOffset = alignTo(header.VerticesOffset + static_cast<uint64_t>(vertexStride) * numVertices, 16);
+    header.FileSize = header.IndicesOffset + sizeof(uint32_t) * static_cast<uint64_t>(numIndices);
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), ec);
+
+    // Write to a temporary file first so a concurrent reader never maps a partial cache
+    std::string tmpPath = cachePath + ".tmp";
+    std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+
+    if (!f.is_open()) {
+        printf(RED_TEXT "Unable to write mesh cache '%s'" RESET_TEXT "\n", cachePath.c_str());
+        return false;
+    }
+
+    const char padding[16] = { 0 };
+
+    f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    f.write(reinterpret_cast<const char*>(meshRecords.data()), sizeof(MeshRecord) * meshRecords.size());
+    f.write(reinterpret_cast<const char*>(materialRecords.data()), sizeof(MaterialRecord) * materialRecords.size());
+    f.write(names.data(), names.size());
+    f.write(padding, header.VerticesOffset - (header.NamesOffset + names.size()));
+    f.write(static_cast<const char*>(pVertices), static_cast<std::streamsize>(vertexStride) * numVertices);
+    f.write(padding, header.IndicesOffset - (header.VerticesOffset + static_cast<uint64_t>(vertexStride) * numVertices));
+    f.write(reinterpret_cast<const char*>(pIndices), sizeof(uint32_t) * static_cast<std::streamsize>(numIndices));
+    f.close();
+
+    if (!f) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    return !ec;
+}
+
+bool MeshCache::open(const std::string& cachePath, const std::string& sourceFile, SourceInfo& source,
+                     uint32_t loadFlags, uint32_t pipelineFlags, uint32_t vertexStride)
+{
+    close();
+
+    int fd = ::open(cachePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* pMapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (pMapping == MAP_FAILED) {
+        return false;
+    }
+
+    m_pData = static_cast<const unsigned char*>(pMapping);
+    m_size = static_cast<size_t>(st.st_size);
+
+    const Header& header = getHeader();
+
+    bool valid = header.Magic == MAGIC &&
+                 header.Version == VERSION &&
+                 header.LoadFlags == loadFlags &&
+                 header.PipelineFlags == pipelineFlags &&
+                 header.VertexStride == vertexStride &&
+                 header.FileSize == m_size &&
+                 validateLayout();
+
+    // Size and modification time decide without reading the source; the contents are only
+    // hashed when those differ, e.g. after a copy or a touch that left the model unchanged
+    if (valid && (header.SourceSize != source.Size || header.SourceMTime != source.MTime)) {
+        valid = header.SourceSize == source.Size &&
+                (source.Hash != 0 || hashSource(sourceFile, source)) &&
+                header.SourceHash == source.Hash;
+
+        // Same contents under a new time: record it so the next load takes the fast path again
+        if (valid) {
+            updateSourceMTime(cachePath, source.MTime);
+        }
+    }
+
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+// Every section, record and range has to lie inside the mapping, so a truncated or corrupt
+// file falls back to the import instead of reading past the end
+bool MeshCache::validateLayout() const
+{
+    const Header& header = getHeader();
+
+    // offset + size <= limit without overflowing
+    auto fits = [](uint64_t offset, uint64_t size, uint64_t limit) {
+        return offset <= limit && size <= limit - offset;
+    };
+
+    uint64_t recordsSize = sizeof(MeshRecord) * static_cast<uint64_t>(header.NumMeshes) +
+                           sizeof(MaterialRecord) * static_cast<uint64_t>(header.NumMaterials);
+
+    bool sections = fits(sizeof(Header), recordsSize, header.NamesOffset) &&
+                    header.NamesOffset <= header.VerticesOffset &&
+                    header.VerticesOffset % alignof(float) == 0 &&
+                    fits(header.VerticesOffset, static_cast<uint64_t>(header.VertexStride) * header.NumVertices, header.IndicesOffset) &&
+                    header.IndicesOffset % alignof(uint32_t) == 0 &&
+                    fits(header.IndicesOffset, sizeof(uint32_t) * static_cast<uint64_t>(header.NumIndices), m_size);
+
+    if (!sections) {
+        return false;
+    }
+
+    uint64_t namesSize = header.VerticesOffset - header.NamesOffset;
+    const MeshRecord* pMeshes = getMeshes();
+
+    for (uint32_t i = 0; i < header.NumMeshes; i++) {
+        const MeshRecord& record = pMeshes[i];
+
+        bool inRange = fits(record.NameOffset, record.NameLength, namesSize) &&
+                       record.Parent >= -1 && record.Parent < static_cast<int64_t>(header.NumMeshes) &&
+                       fits(record.BaseVertex, record.NumVertices, header.NumVertices) &&
+                       fits(record.BaseIndex, record.NumIndices, header.NumIndices) &&
+                       record.MaterialIndex < header.NumMaterials &&
+                       record.NumLods <= MAX_LODS;
+
+        if (!inRange) {
+            return false;
+        }
+
+        for (uint32_t level = 0; level < record.NumLods; level++) {
+            if (!fits(record.LodBaseIndex[level], record.LodNumIndices[level], header.NumIndices)) {
+                return false;
+            }
+        }
+
+        // A parent chain longer than the mesh count has a cycle
+        int32_t parent = record.Parent;
+        for (uint32_t depth = 0; parent >= 0; depth++) {
+            if (depth == header.NumMeshes) {
+                return false;
+            }
+            parent = pMeshes[parent].Parent;
+        }
+    }
+
+    return true;
+}
+
+// Rewrites SourceMTime in place. The private mapping is not affected, and a failure only
+// means the next load hashes the source once more.
+bool MeshCache::updateSourceMTime(const std::string& cachePath, int64_t mtime)
+{
+    int fd = ::open(cachePath.c_str(), O_WRONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    ssize_t written = pwrite(fd, &mtime, sizeof(mtime), offsetof(Header, SourceMTime));
+    ::close(fd);
+
+    return written == static_cast<ssize_t>(sizeof(mtime));
+}
+
+void MeshCache::close()
+{
+    if (m_pData) {
+        munmap(const_cast<unsigned char*>(m_pData), m_size);
+        m_pData = nullptr;
+        m_size = 0;
+    }
+}
+
+const MeshCache::MeshRecord* MeshCache::getMeshes() const
+{
+    return reinterpret_cast<const MeshRecord*>(m_pData + sizeof(Header));
+}
+
+const MeshCache::MaterialRecord* MeshCache::getMaterials() const
+{
+    return reinterpret_cast<const MaterialRecord*>(m_pData + sizeof(Header) + sizeof(MeshRecord) * getHeader().NumMeshes);
+}
+
+std::string MeshCache::getName(const MeshRecord& record) const
+{
+    const char* pNames = reinterpret_cast<const char*>(m_pData + getHeader().NamesOffset);
+    return std::string(pNames + record.NameOffset, record.NameLength);
+}
+
+const void* MeshCache::getVertices() const
+{
+    return m_pData + getHeader().VerticesOffset;
+}
+
+const uint32_t* MeshCache::getIndices() const
+{
+    return reinterpret_cast<const uint32_t*>(m_pData + getHeader().IndicesOffset);
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "stb_image_write.h"
+
+#include "offscreenTarget.hpp"
+#include "utils.hpp"
+
+OffscreenTarget::~OffscreenTarget()
+{
+    if (m_FBO == 0) {
+        return;
+    }
+
+    GLuint framebuffers[2] = { m_FBO, m_resolveFBO };
+    GLuint renderbuffers[3] = { m_colorRBO, m_depthRBO, m_resolveRBO };
+
+    glDeleteFramebuffers(2, framebuffers);
+    glDeleteRenderbuffers(3, renderbuffers);
+}
+
+bool OffscreenTarget::init(int width, int height, int samples)
+{
+    GLint maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+
+    m_width = width;
+    m_height = height;
+    m_samples = std::clamp(samples, 0, static_cast<int>(maxSamples));
+
+    glCreateRenderbuffers(1, &m_colorRBO);
+    glNamedRenderbufferStorageMultisample(m_colorRBO, m_samples, GL_RGBA8, width, height);
+    glCreateRenderbuffers(1, &m_depthRBO);
+    glNamedRenderbufferStorageMultisample(m_depthRBO, m_samples, GL_DEPTH_COMPONENT24, width, height);
+
+    glCreateFramebuffers(1, &m_FBO);
+    glNamedFramebufferRenderbuffer(m_FBO, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorRBO);
+    glNamedFramebufferRenderbuffer(m_FBO, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRBO);
+
+    // Multisampled renderbuffers cannot be read directly, they are blitted into this one first
+    glCreateRenderbuffers(1, &m_resolveRBO);
+    glNamedRenderbufferStorage(m_resolveRBO, GL_RGBA8, width, height);
+    glCreateFramebuffers(1, &m_resolveFBO);
+    glNamedFramebufferRenderbuffer(m_resolveFBO, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_resolveRBO);
+    glNamedFramebufferReadBuffer(m_resolveFBO, GL_COLOR_ATTACHMENT0);
+
+    GLenum status = glCheckNamedFramebufferStatus(m_FBO, GL_DRAW_FRAMEBUFFER);
+    GLenum resolveStatus = glCheckNamedFramebufferStatus(m_resolveFBO, GL_READ_FRAMEBUFFER);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE || resolveStatus != GL_FRAMEBUFFER_COMPLETE) {
+        printf(RED_TEXT "Offscreen framebuffer incomplete (0x%x, 0x%x)" RESET_TEXT "\n", status, resolveStatus);
+        return false;
+    }
+
+    m_pixels.resize(static_cast<size_t>(width) * height * 3);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void OffscreenTarget::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    glViewport(0, 0, m_width, m_height);
+}
+
+bool OffscreenTarget::savePng(const std::string& path)
+{
+    glBlitNamedFramebuffer(m_FBO, m_resolveFBO, 0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_resolveFBO);
+    // RGB only: blended passes leave destination alpha below one, which would make the PNG translucent
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, m_pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_FBO);
+
+    // GL rows start at the bottom, PNG rows at the top
+    stbi_flip_vertically_on_write(1);
+
+    if (!stbi_write_png(path.c_str(), m_width, m_height, 3, m_pixels.data(), m_width * 3)) {
+        printf(RED_TEXT "Failed to write '%s'" RESET_TEXT "\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
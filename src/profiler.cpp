@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstring>
+
+#include "imgui.h"
+
+#include "profiler.hpp"
+
+// Weight of the newest sample in the moving averages
+static const float AVERAGE_WEIGHT = 0.05f;
+
+Profiler::~Profiler()
+{
+    if (m_queries[0][0] != 0) {
+        glDeleteQueries(NUM_QUERY_FRAMES * MAX_SCOPES, &m_queries[0][0]);
+    }
+}
+
+bool Profiler::init()
+{
+    glCreateQueries(GL_TIME_ELAPSED, NUM_QUERY_FRAMES * MAX_SCOPES, &m_queries[0][0]);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void Profiler::beginFrame()
+{
+    // The query set reused this frame was issued NUM_QUERY_FRAMES frames ago
+    collectGpuResults(m_frame % NUM_QUERY_FRAMES);
+
+    m_frameStart = std::chrono::steady_clock::now();
+    m_frameStarted = true;
+}
+
+void Profiler::endFrame()
+{
+    if (!m_frameStarted) {
+        return;
+    }
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_frameStart).count();
+
+    m_frameMs[m_historyOffset] = ms;
+    m_historyOffset = (m_historyOffset + 1) % HISTORY_SIZE;
+    m_maxFrameMs = *std::max_element(m_frameMs, m_frameMs + HISTORY_SIZE);
+
+    m_frameStarted = false;
+    m_frame++;
+}
+
+void Profiler::beginScope(const char* pName)
+{
+    if (m_activeScope >= 0) {
+        return;
+    }
+
+    uint32_t index = 0;
+    while (index < m_numScopes && strcmp(m_scopes[index].pName, pName) != 0) {
+        index++;
+    }
+
+    if (index == m_numScopes) {
+        if (m_numScopes == MAX_SCOPES) {
+            return;
+        }
+
+        m_scopes[m_numScopes++].pName = pName;
+    }
+
+    uint32_t queryFrame = m_frame % NUM_QUERY_FRAMES;
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[queryFrame][index]);
+    m_queryIssued[queryFrame][index] = true;
+
+    m_activeScope = static_cast<int>(index);
+    m_scopeStart = std::chrono::steady_clock::now();
+}
+
+void Profiler::endScope()
+{
+    if (m_activeScope < 0) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+
+    ScopeStats& scope = m_scopes[m_activeScope];
+    scope.CpuMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_scopeStart).count();
+    scope.AvgCpuMs += (scope.CpuMs - scope.AvgCpuMs) * AVERAGE_WEIGHT;
+
+    m_activeScope = -1;
+}
+
+void Profiler::collectGpuResults(uint32_t queryFrame)
+{
+    for (uint32_t i = 0; i < m_numScopes; i++) {
+        if (!m_queryIssued[queryFrame][i]) {
+            continue;
+        }
+
+        // A result that is still pending is dropped instead of waited for
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[queryFrame][i], GL_QUERY_RESULT_AVAILABLE, &available);
+        m_queryIssued[queryFrame][i] = false;
+
+        if (!available) {
+            continue;
+        }
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(m_queries[queryFrame][i], GL_QUERY_RESULT, &ns);
+
+        ScopeStats& scope = m_scopes[i];
+        scope.GpuMs = ns / 1e6f;
+        scope.AvgGpuMs += (scope.GpuMs - scope.AvgGpuMs) * AVERAGE_WEIGHT;
+    }
+}
+
+void Profiler::drawGui() const
+{
+    if (!ImGui::CollapsingHeader("Profiler", ImGuiTreeNodeFlags_DefaultOpen)) {
+        return;
+    }
+
+    float lastMs = m_frameMs[(m_historyOffset + HISTORY_SIZE - 1) % HISTORY_SIZE];
+
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "%.2f ms (max %.2f)", lastMs, m_maxFrameMs);
+    ImGui::PlotLines("Frame", m_frameMs, HISTORY_SIZE, m_historyOffset, overlay, 0.0f, std::max(m_maxFrameMs, 16.7f), ImVec2(0.0f, 80.0f));
+
+    if (ImGui::BeginTable("Passes", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Pass");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("CPU avg");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableSetupColumn("GPU avg");
+        ImGui::TableHeadersRow();
+
+        for (uint32_t i = 0; i < m_numScopes; i++) {
+            const ScopeStats& scope = m_scopes[i];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(scope.pName);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.CpuMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.AvgCpuMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.GpuMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.AvgGpuMs);
+        }
+
+        ImGui::EndTable();
+    }
+}
@@ -0,0 +1,166 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "programCache.hpp"
+
+ProgramCache& ProgramCache::instance()
+{
+    static ProgramCache cache;
+    return cache;
+}
+
+std::string ProgramCache::getCachePath(uint64_t key)
+{
+    return utils::disk::getCurrentDirectory() + "/cache/programs/" + utils::hash::toHex(key) + ".glprog";
+}
+
+bool ProgramCache::isEnabled()
+{
+    if (m_enabled && !m_formatsChecked) {
+        GLint numFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        m_formatsChecked = true;
+
+        if (numFormats == 0) {
+            printf("Program cache: the driver offers no program binary formats, compiling from source\n");
+            m_enabled = false;
+        }
+    }
+
+    return m_enabled;
+}
+
+uint64_t ProgramCache::getDriverHash()
+{
+    if (!m_driverHashed) {
+        const GLenum names[4] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+
+        uint32_t version = VERSION;
+        m_driverHash = utils::hash::fnv1a64(&version, sizeof(version));
+        for (GLenum name : names) {
+            const char* pValue = reinterpret_cast<const char*>(glGetString(name));
+            if (pValue) {
+                m_driverHash = utils::hash::fnv1a64(pValue, strlen(pValue) + 1, m_driverHash);
+            }
+        }
+
+        m_driverHashed = true;
+    }
+
+    return m_driverHash;
+}
+
+bool ProgramCache::load(GLuint program, uint64_t key)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    std::string data;
+    std::string path = getCachePath(key);
+
+    // No file is a plain miss
+    if (!std::filesystem::exists(path)) {
+        return false;
+    }
+
+    Header header;
+    bool valid = utils::disk::readBinaryFile(path, data) && data.size() >= sizeof(Header);
+
+    if (valid) {
+        memcpy(&header, data.data(), sizeof(header));
+
+        valid = header.Magic == MAGIC &&
+                header.Version == VERSION &&
+                header.Key == key &&
+                sizeof(Header) + header.BinaryLength == data.size();
+    }
+
+    if (!valid) {
+        m_invalid++;
+        return false;
+    }
+
+    GLint linked = GL_FALSE;
+    glProgramBinary(program, header.BinaryFormat, data.data() + sizeof(Header), header.BinaryLength);
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+    if (!linked) {
+        m_rejected++;
+        return false;
+    }
+
+    m_hits++;
+    return true;
+}
+
+bool ProgramCache::store(GLuint program, uint64_t key)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0) {
+        return false;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    Header header;
+    header.Magic = MAGIC;
+    header.Version = VERSION;
+    header.Key = key;
+    header.BinaryFormat = format;
+    header.BinaryLength = static_cast<uint32_t>(length);
+
+    std::string path = getCachePath(key);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    // Write to a temporary file first so a concurrent launch never loads a partial binary
+    std::string tmpPath = path + ".tmp";
+    std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+
+    if (!f.is_open()) {
+        printf(RED_TEXT "Unable to write program cache '%s'" RESET_TEXT "\n", path.c_str());
+        return false;
+    }
+
+    f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    f.write(binary.data(), length);
+    f.close();
+
+    if (!f) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+void ProgramCache::printStats()
+{
+    printf("Programs: %u from cache in %.2f ms, %u compiled in %.2f ms", m_hits, m_loadMs, m_compiled, m_compileMs);
+
+    if (m_rejected > 0) {
+        printf(" (%u cached binaries rejected by the driver)", m_rejected);
+    }
+
+    if (m_invalid > 0) {
+        printf(" (%u cache files unreadable, truncated or from another version)", m_invalid);
+    }
+
+    if (!m_enabled) {
+        printf(", cache disabled");
+    }
+
+    printf("\n");
+}
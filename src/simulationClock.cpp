@@ -0,0 +1,44 @@
+#include <algorithm>
+
+#include "simulationClock.hpp"
+
+SimulationClock::SimulationClock(double fixedStep) : m_lastFrame(std::chrono::steady_clock::now()), m_fixedStep(fixedStep)
+{
+}
+
+int SimulationClock::advance()
+{
+    auto now = std::chrono::steady_clock::now();
+    double frameSeconds = std::chrono::duration<double>(now - m_lastFrame).count();
+    m_lastFrame = now;
+
+    return advanceBy(frameSeconds);
+}
+
+int SimulationClock::advanceBy(double frameSeconds)
+{
+    m_frameSeconds = frameSeconds;
+    m_elapsedSeconds += m_frameSeconds;
+
+    if (m_paused) {
+        return 0;
+    }
+
+    double simulatedSeconds = std::min(m_frameSeconds, MAX_FRAME_SECONDS) * m_timeScale;
+    double stepStart = m_simulationTime - m_accumulator;
+    m_accumulator += simulatedSeconds;
+
+    int numSteps = 0;
+    while (m_accumulator >= m_fixedStep && numSteps < MAX_STEPS_PER_FRAME) {
+        m_accumulator -= m_fixedStep;
+        numSteps++;
+    }
+
+    // Whatever is still owed after the cap is dropped instead of piling up
+    if (m_accumulator >= m_fixedStep) {
+        m_accumulator = 0.0;
+    }
+    m_simulationTime = stepStart + numSteps * m_fixedStep + m_accumulator;
+
+    return numSteps;
+}
@@ -1,4 +1,10 @@
+#include <chrono>
+#include <cstring>
+
+#include "frameUniforms.hpp"
+#include "programCache.hpp"
 #include "technique.hpp"
+#include "trace.hpp"
 
 Technique::Technique()
 {
@@ -43,56 +49,172 @@ bool Technique::AddShader(GLenum ShaderType, const char* pFilename)
         return false;
     }
 
-    GLuint ShaderObj = glCreateShader(ShaderType);
+    return AddShaderSource(ShaderType, s.c_str(), pFilename);
+}
 
-    if (ShaderObj == 0) {
-        fprintf(stderr, "Error creating shader type %d\n", ShaderType);
+// Same as AddShader() for shaders embedded in the code. pName only shows up in error messages.
+// Compilation happens in Finalize(), the errors are reported by Complete().
+bool Technique::AddShaderSource(GLenum ShaderType, const char* pSource, const char* pName)
+{
+    if (pSource == nullptr) {
+        fprintf(stderr, "No source for shader '%s'\n", pName);
         return false;
     }
 
-    // Save the shader object - will be deleted in the destructor
-    m_shaderObjList.push_back(ShaderObj);
+    m_shaderSources.push_back({ ShaderType, pSource, pName });
 
-    const GLchar* p[1];
-    p[0] = s.c_str();
-    GLint Lengths[1] = { (GLint)s.size() };
+    return true;
+}
 
-    glShaderSource(ShaderObj, 1, p, Lengths);
+// Lets the driver compile and link on its own threads (GL_KHR_parallel_shader_compile)
+bool Technique::EnableParallelCompile()
+{
+    // 0xFFFFFFFF leaves the number of threads to the driver
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        return true;
+    }
 
-    glCompileShader(ShaderObj);
+    if (GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        return true;
+    }
 
-    GLint success;
-    glGetShaderiv(ShaderObj, GL_COMPILE_STATUS, &success);
+    return false;
+}
 
-    if (!success) {
-        GLchar InfoLog[1024];
-        glGetShaderInfoLog(ShaderObj, 1024, NULL, InfoLog);
-        fprintf(stderr, "Error compiling '%s': '%s'\n", pFilename, InfoLog);
-        return false;
+// Issues the compile of the added sources and the link into m_shaderProg. Nothing here
+// queries a status, so with parallel compilation the driver does the work in the background
+// and only Complete() waits for it.
+bool Technique::IssueCompileAndLink()
+{
+    for (const ShaderSource& Shader : m_shaderSources) {
+        GLuint ShaderObj = glCreateShader(Shader.Type);
+
+        if (ShaderObj == 0) {
+            fprintf(stderr, "Error creating shader type %d\n", Shader.Type);
+            return false;
+        }
+
+        // Save the shader object - will be deleted in the destructor
+        m_shaderObjList.push_back(ShaderObj);
+
+        const GLchar* p[1];
+        p[0] = Shader.Source.c_str();
+        GLint Lengths[1] = { (GLint)Shader.Source.size() };
+
+        glShaderSource(ShaderObj, 1, p, Lengths);
+
+        glCompileShader(ShaderObj);
+
+        glAttachShader(m_shaderProg, ShaderObj);
     }
 
-    glAttachShader(m_shaderProg, ShaderObj);
+    // Without the hint some drivers return an empty binary
+    if (ProgramCache::instance().isEnabled()) {
+        glProgramParameteri(m_shaderProg, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    glLinkProgram(m_shaderProg);
 
     return true;
 }
 
+// A failed link usually comes from a failed compile, whose log names the shader and the line
+void Technique::PrintCompileErrors()
+{
+    GLuint Index = 0;
+
+    for (ShaderObjList::iterator it = m_shaderObjList.begin() ; it != m_shaderObjList.end() ; it++, Index++) {
+        GLint Success = 0;
+        glGetShaderiv(*it, GL_COMPILE_STATUS, &Success);
+
+        if (!Success) {
+            GLchar InfoLog[1024];
+            glGetShaderInfoLog(*it, 1024, NULL, InfoLog);
+            fprintf(stderr, "Error compiling '%s': '%s'\n", Index < m_shaderNames.size() ? m_shaderNames[Index].c_str() : "?", InfoLog);
+        }
+    }
+}
+
 // After all the shaders have been added to the program call this function
-// to link and validate the program.
+// to link the program. The linked binary is taken from the program cache when
+// the same sources were built by the same driver before. Unless completion is
+// deferred the program is completed right away.
 bool Technique::Finalize()
 {
+    TRACE_SCOPE("Technique::Finalize");
+
+    ProgramCache& Cache = ProgramCache::instance();
+    auto Start = std::chrono::steady_clock::now();
+
+    m_cacheKey = Cache.getDriverHash();
+    for (const ShaderSource& Shader : m_shaderSources) {
+        m_cacheKey = utils::hash::fnv1a64(&Shader.Type, sizeof(Shader.Type), m_cacheKey);
+        m_cacheKey = utils::hash::fnv1a64(Shader.Source.data(), Shader.Source.size(), m_cacheKey);
+    }
+
+    m_fromCache = Cache.load(m_shaderProg, m_cacheKey);
+
+    if (m_fromCache) {
+        Cache.addLoadTime(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+    } else {
+        m_shaderNames.clear();
+        for (const ShaderSource& Shader : m_shaderSources) {
+            m_shaderNames.push_back(Shader.Name);
+        }
+
+        if (!IssueCompileAndLink()) {
+            m_linkState = LINK_FAILED;
+            return false;
+        }
+
+        m_issueMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+    }
+
+    m_shaderSources.clear();
+    m_linkState = LINK_PENDING;
+
+    return m_deferCompletion ? true : Complete();
+}
+
+// Queries the link status, which blocks only if the driver is still working on the program,
+// stores a freshly linked binary in the cache and validates the program
+bool Technique::Complete()
+{
+    if (m_linkState != LINK_PENDING) {
+        return m_linkState == LINK_DONE;
+    }
+
+    TRACE_SCOPE("Technique::Complete");
+
     GLint Success = 0;
     GLchar ErrorLog[1024] = { 0 };
 
-    glLinkProgram(m_shaderProg);
+    auto Start = std::chrono::steady_clock::now();
+    m_linkState = LINK_FAILED;
 
     glGetProgramiv(m_shaderProg, GL_LINK_STATUS, &Success);
 
     if (Success == 0) {
+        PrintCompileErrors();
         glGetProgramInfoLog(m_shaderProg, sizeof(ErrorLog), NULL, ErrorLog);
         fprintf(stderr, "Error linking shader program: '%s'\n", ErrorLog);
         return false;
     }
 
+    if (!m_fromCache) {
+        ProgramCache& Cache = ProgramCache::instance();
+        Cache.store(m_shaderProg, m_cacheKey);
+        Cache.addCompileTime(m_issueMs + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+    }
+
+    // Programs that declare FRAME_DATA_GLSL read camera and lighting state from the shared uniform buffer
+    GLuint FrameDataIndex = glGetUniformBlockIndex(m_shaderProg, "FrameData");
+    if (FrameDataIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(m_shaderProg, FrameDataIndex, FRAME_DATA_BINDING);
+    }
+
     glValidateProgram(m_shaderProg);
 
     glGetProgramiv(m_shaderProg, GL_VALIDATE_STATUS, &Success);
@@ -109,7 +231,14 @@ bool Technique::Finalize()
     }
 
     m_shaderObjList.clear();
-    return GLCheckError();
+    m_shaderNames.clear();
+
+    if (!OnLinked() || !GLCheckError()) {
+        return false;
+    }
+
+    m_linkState = LINK_DONE;
+    return true;
 }
 
 void Technique::PrintUniformList()
@@ -131,9 +260,21 @@ void Technique::PrintUniformList()
     }
 }
 
-void Technique::Enable()
+// Returns false, with no program bound, when the program failed to build; the caller skips its draws
+bool Technique::Enable()
 {
+    // First use of a deferred program; a link the driver has not finished yet blocks here
+    if (m_linkState == LINK_PENDING) {
+        Complete();
+    }
+
+    if (m_linkState != LINK_DONE) {
+        glUseProgram(0);
+        return false;
+    }
+
     glUseProgram(m_shaderProg);
+    return true;
 }
 
 GLint Technique::GetUniformLocation(const char* pUniformName)
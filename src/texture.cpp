@@ -3,6 +3,7 @@
 #include <math.h>
 
 #include "texture.hpp"
+#include "trace.hpp"
 
 Texture::Texture(GLenum TextureTarget, const std::string& FileName)
 {
@@ -15,33 +16,74 @@ Texture::Texture(GLenum TextureTarget)
     m_textureTarget = TextureTarget;
 }
 
-void Texture::Load(unsigned int  BufferSize, void* pData)
+Texture::~Texture()
 {
-    void* pImageData = stbi_load_from_memory((const stbi_uc*)pData, BufferSize, &m_imageWidth, &m_imageHeight, &m_imageBPP, 0);
+    if (m_pDecodedData) {
+        stbi_image_free(m_pDecodedData);
+    }
 
-    LoadInternal(pImageData);
+    if (m_textureObj != 0) {
+        glDeleteTextures(1, &m_textureObj);
+    }
+}
 
-    stbi_image_free(pImageData);
+void Texture::Load(unsigned int  BufferSize, void* pData)
+{
+    TRACE_SCOPE("Texture::Load");
+
+    Decode(BufferSize, pData);
+    Upload();
 }
 
 bool Texture::Load()
 {
-    stbi_set_flip_vertically_on_load(1);
+    TRACE_SCOPE("Texture::Load");
 
-    unsigned char* pImageData = stbi_load(m_fileName.c_str(), &m_imageWidth, &m_imageHeight, &m_imageBPP, 0);
-
-    if (!pImageData) {
+    if (!Decode()) {
         printf("Can't load texture from '%s' - %s\n", m_fileName.c_str(), stbi_failure_reason());
         exit(0);
     }
 
     printf("Width %d, height %d, bpp %d\n", m_imageWidth, m_imageHeight, m_imageBPP);
 
-    LoadInternal(pImageData);
+    Upload();
 
     return true;
 }
 
+bool Texture::Decode()
+{
+    TRACE_SCOPE("Texture::Decode");
+
+    // The per-thread flag keeps concurrent decodes from racing on stb's global setting
+    stbi_set_flip_vertically_on_load_thread(1);
+
+    m_pDecodedData = stbi_load(m_fileName.c_str(), &m_imageWidth, &m_imageHeight, &m_imageBPP, 0);
+
+    return m_pDecodedData != NULL;
+}
+
+bool Texture::Decode(unsigned int BufferSize, const void* pData)
+{
+    TRACE_SCOPE("Texture::Decode");
+
+    stbi_set_flip_vertically_on_load_thread(0);
+
+    m_pDecodedData = stbi_load_from_memory((const stbi_uc*)pData, BufferSize, &m_imageWidth, &m_imageHeight, &m_imageBPP, 0);
+
+    return m_pDecodedData != NULL;
+}
+
+void Texture::Upload()
+{
+    TRACE_SCOPE("Texture::Upload");
+
+    LoadInternal(m_pDecodedData);
+
+    stbi_image_free(m_pDecodedData);
+    m_pDecodedData = NULL;
+}
+
 void Texture::Load(const std::string& Filename)
 {
     m_fileName = Filename;
@@ -53,6 +95,8 @@ void Texture::Load(const std::string& Filename)
 
 void Texture::LoadRaw(int Width, int Height, int BPP, const unsigned char* pImageData)
 {
+    TRACE_SCOPE("Texture::LoadRaw");
+
     m_imageWidth = Width;
     m_imageHeight = Height;
     m_imageBPP = BPP;
@@ -115,7 +159,7 @@ void Texture::LoadInternalDSA(const void* pImageData)
 {
     glCreateTextures(m_textureTarget, 1, &m_textureObj);
 
-    int Levels = std::min(5, (int)log2f((float)std::max(m_imageWidth, m_imageHeight)));
+    int Levels = GetNumLevels();
 
     if (m_textureTarget == GL_TEXTURE_2D) {
         switch (m_imageBPP) {
@@ -161,8 +205,33 @@ void Texture::LoadInternalDSA(const void* pImageData)
     glGenerateTextureMipmap(m_textureObj);
 }
 
+int Texture::GetNumLevels() const
+{
+    return std::min(5, (int)log2f((float)std::max(m_imageWidth, m_imageHeight)));
+}
+
+size_t Texture::GetResidentBytes() const
+{
+    if (m_textureObj == 0) {
+        return 0;
+    }
+
+    size_t Bytes = 0;
+    int Levels = std::max(1, GetNumLevels());
+
+    for (int Level = 0; Level < Levels; Level++) {
+        size_t Width = std::max(1, m_imageWidth >> Level);
+        size_t Height = std::max(1, m_imageHeight >> Level);
+        Bytes += Width * Height * std::max(1, m_imageBPP);
+    }
+
+    return Bytes;
+}
+
 void Texture::LoadF32(int Width, int Height, const float* pImageData)
 {
+    TRACE_SCOPE("Texture::LoadF32");
+
      m_imageWidth = Width;
     m_imageHeight = Height;
 
@@ -0,0 +1,87 @@
+#include "textureCache.hpp"
+
+TextureCache& TextureCache::instance()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+std::string TextureCache::keyForFile(const std::string& fullPath)
+{
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(fullPath, ec);
+
+    return "file:" + (ec ? fullPath : canonical.string());
+}
+
+std::string TextureCache::keyForEmbedded(const aiTexture* paiTexture)
+{
+    // Compressed textures keep their byte size in mWidth, raw ones are mWidth x mHeight texels
+    size_t size = paiTexture->mHeight == 0 ? paiTexture->mWidth
+                                           : sizeof(aiTexel) * paiTexture->mWidth * paiTexture->mHeight;
+    uint64_t hash = utils::hash::fnv1a64(paiTexture->pcData, size);
+
+    return "embedded:" + utils::hash::toHex(hash) + ":" + std::to_string(size);
+}
+
+std::shared_ptr<Texture> TextureCache::acquire(const std::string& key, GLenum textureTarget, const std::string& fileName, bool& isNew)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_textures.find(key);
+    if (it != m_textures.end()) {
+        if (std::shared_ptr<Texture> pTexture = it->second.lock()) {
+            m_hits++;
+            isNew = false;
+            return pTexture;
+        }
+    }
+
+    std::shared_ptr<Texture> pTexture = fileName.empty() ? std::make_shared<Texture>(textureTarget)
+                                                         : std::make_shared<Texture>(textureTarget, fileName);
+    m_textures[key] = pTexture;
+    m_misses++;
+    isNew = true;
+
+    return pTexture;
+}
+
+size_t TextureCache::getNumTextures()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t count = 0;
+    for (const auto& entry : m_textures) {
+        if (!entry.second.expired()) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+size_t TextureCache::getResidentBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t bytes = 0;
+    for (auto it = m_textures.begin(); it != m_textures.end();) {
+        if (std::shared_ptr<Texture> pTexture = it->second.lock()) {
+            bytes += pTexture->GetResidentBytes();
+            ++it;
+        } else {
+            it = m_textures.erase(it);
+        }
+    }
+
+    return bytes;
+}
+
+void TextureCache::printStats()
+{
+    size_t bytes = getResidentBytes();
+    size_t count = getNumTextures();
+
+    printf("Texture cache: %zu textures, %.2f MB resident, %lu hits, %lu misses\n",
+           count, bytes / (1024.0 * 1024.0), (unsigned long)getHits(), (unsigned long)getMisses());
+}
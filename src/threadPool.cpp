@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include "threadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+{
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < numThreads; i++) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_jobAvailable.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push(std::move(job));
+    }
+
+    m_jobAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobsDone.wait(lock, [this]() { return m_jobs.empty() && m_activeJobs == 0; });
+}
+
+size_t ThreadPool::getPendingJobs()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size() + m_activeJobs;
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+            if (m_stopping && m_jobs.empty()) {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+            m_activeJobs++;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_activeJobs--;
+        }
+
+        m_jobsDone.notify_all();
+    }
+}
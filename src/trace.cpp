@@ -0,0 +1,145 @@
+#include "trace.hpp"
+
+#ifdef GFX_ENABLE_TRACING
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace Trace
+{
+    static const uint32_t EVENTS_PER_THREAD = 1 << 18;
+
+    struct Event {
+        const char* pName;
+        uint64_t StartNs;
+        uint64_t EndNs;
+    };
+
+    // Written by its owning thread only. Count is published with release semantics after the
+    // event is filled in, so dump() can read every event below it from another thread.
+    struct ThreadBuffer {
+        uint32_t Tid = 0;
+        std::string Name;
+        std::unique_ptr<Event[]> Events = std::unique_ptr<Event[]>(new Event[EVENTS_PER_THREAD]);
+        std::atomic<uint32_t> Count = 0;
+        std::atomic<uint64_t> Dropped = 0;
+    };
+
+    // Buffers outlive their threads so that pool and loader threads still show up in a dump at exit
+    static std::mutex s_registryMutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+    static const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+
+    static ThreadBuffer& getThreadBuffer()
+    {
+        thread_local ThreadBuffer* pBuffer = nullptr;
+
+        if (pBuffer == nullptr) {
+            std::lock_guard<std::mutex> lock(s_registryMutex);
+            s_buffers.push_back(std::make_unique<ThreadBuffer>());
+            pBuffer = s_buffers.back().get();
+            pBuffer->Tid = static_cast<uint32_t>(s_buffers.size());
+        }
+
+        return *pBuffer;
+    }
+
+    uint64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+    }
+
+    void record(const char* pName, uint64_t startNs, uint64_t endNs)
+    {
+        ThreadBuffer& buffer = getThreadBuffer();
+        uint32_t count = buffer.Count.load(std::memory_order_relaxed);
+
+        if (count == EVENTS_PER_THREAD) {
+            buffer.Dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer.Events[count] = { pName, startNs, endNs };
+        buffer.Count.store(count + 1, std::memory_order_release);
+    }
+
+    void setThreadName(const char* pName)
+    {
+        ThreadBuffer& buffer = getThreadBuffer();
+
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        buffer.Name = pName;
+    }
+
+    static void writeEscaped(std::ofstream& f, const char* pText)
+    {
+        for (const char* p = pText; *p; p++) {
+            if (*p == '"' || *p == '\\') {
+                f << '\\';
+            }
+            f << *p;
+        }
+    }
+
+    bool dump(const std::string& path)
+    {
+        std::ofstream f(path, std::ios::trunc);
+
+        if (!f.is_open()) {
+            printf(RED_TEXT "Unable to write trace '%s'" RESET_TEXT "\n", path.c_str());
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+
+        size_t numEvents = 0;
+        uint64_t numDropped = 0;
+        bool first = true;
+
+        f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        for (const std::unique_ptr<ThreadBuffer>& pBuffer : s_buffers) {
+            if (!pBuffer->Name.empty()) {
+                f << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << pBuffer->Tid
+                  << ",\"args\":{\"name\":\"";
+                writeEscaped(f, pBuffer->Name.c_str());
+                f << "\"}}";
+                first = false;
+            }
+
+            uint32_t count = pBuffer->Count.load(std::memory_order_acquire);
+
+            for (uint32_t i = 0; i < count; i++) {
+                const Event& event = pBuffer->Events[i];
+                char times[96];
+                snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", event.StartNs / 1000.0, (event.EndNs - event.StartNs) / 1000.0);
+
+                f << (first ? "" : ",\n") << "{\"name\":\"";
+                writeEscaped(f, event.pName);
+                f << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << pBuffer->Tid << "," << times << "}";
+                first = false;
+            }
+
+            numEvents += count;
+            numDropped += pBuffer->Dropped.load(std::memory_order_relaxed);
+        }
+
+        f << "\n]}\n";
+        f.close();
+
+        printf("Trace: wrote %zu events from %zu threads to '%s'", numEvents, s_buffers.size(), path.c_str());
+        if (numDropped > 0) {
+            printf(RED_TEXT " (%lu dropped, buffers full)" RESET_TEXT, (unsigned long)numDropped);
+        }
+        printf("\n");
+
+        return static_cast<bool>(f);
+    }
+};
+
+#endif // GFX_ENABLE_TRACING
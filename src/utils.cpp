@@ -14,21 +14,6 @@ namespace fmt {
     };
 }
 
-void shutdownTimer(int seconds, bool* runIndifeinitely)
-{
-    while (seconds > 0 || *runIndifeinitely) {
-        if (!*runIndifeinitely) {
-            std::string title = fmt::format("Shutting down in {} seconds ...", seconds);
-            std::cout << "\033[33m" << title << "\033[0m" << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            seconds--;
-        }
-        else return;        
-    }
-   
-    exit(0);
-}
-
 void utils::printGLVersion()
 {
     const GLubyte* version = glGetString(GL_VERSION);
@@ -118,6 +103,39 @@ bool utils::disk::readFile(const char* pFileName, std::string& outFile)
     return ret;
 }
 
+bool utils::disk::readBinaryFile(const std::string& fileName, std::string& outData)
+{
+    std::ifstream f(fileName, std::ios::binary | std::ios::ate);
+
+    if (!f.is_open()) {
+        return false;
+    }
+
+    std::streamsize size = f.tellg();
+    f.seekg(0, std::ios::beg);
+
+    outData.resize(static_cast<size_t>(size));
+    return static_cast<bool>(f.read(outData.data(), size));
+}
+
+uint64_t utils::hash::fnv1a64(const void* pData, size_t size, uint64_t seed)
+{
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+    uint64_t hash = seed;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= pBytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+std::string utils::hash::toHex(uint64_t value)
+{
+    return fmt::format("{:016x}", value);
+}
+
 void utils::format::clearConsole()
 {
     system("clear");
@@ -137,10 +155,3 @@ void utils::format::printEnd()
     std::cout << std::string(40, '-') << std::endl;
     std::cout << std::endl << ".END" << std::endl;
 }
-void utils::timer::shutdown(int seconds, bool* runIndifeinitely)
-{
-    std::thread shutdownThread([seconds, runIndifeinitely]() {
-        shutdownTimer(seconds, runIndifeinitely);
-    });
-    shutdownThread.detach();
-}